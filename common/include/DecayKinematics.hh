@@ -0,0 +1,343 @@
+/// \file common/include/DecayKinematics.hh
+/// \brief Analytic neutrino kinematics of pi, K and mu decays
+
+#ifndef MirageDecayKinematics_h
+#define MirageDecayKinematics_h 1
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace mirage
+{
+
+/// Neutrino kinematics of the pi+-, K+-, K0L and mu+- decay modes with a
+/// neutrino in the final state, sampled analytically from the parent
+/// 4-momentum.
+///
+/// Plain C++ (no Geant4, no ROOT) so that the simulation and the offline
+/// tools share the same kernel. Energies and momenta are in GeV.
+///
+/// - pi -> mu nu, pi -> e nu and K -> mu nu: two-body, isotropic in the
+///   parent rest frame.
+/// - K -> pi e nu, K -> pi mu nu (K+- and K0L): Dalitz density of the Kl3
+///   decays with a linear f+(t) = 1 + lambda+ t / m_pi^2 and a constant
+///   xi = f-/f+, with the parameters of G4KL3DecayChannel.
+/// - mu- -> e- nubar_e nu_mu (and its conjugate): both neutrinos of every
+///   decay, from the V-A spectra of an unpolarised muon with massless
+///   leptons, x = 2E/m_mu: 2x^2(3 - 2x) for nu_mu, 12x^2(1 - x) for
+///   nubar_e. The two are drawn independently and isotropically, which is
+///   right for the flux of each flavour but not for their correlation; the
+///   polarisation of muons from pi and K decays is ignored.
+///
+/// The sampler decays one parent many times at once. Every step runs over
+/// the whole batch in structure-of-arrays form, with no branches in the loop
+/// bodies, so the compiler can vectorise them. The uniform random numbers
+/// come from a caller-supplied source, `void flat(int n, double* u)`.
+
+namespace DecayKinematics
+{
+  constexpr double kMassPion = 0.13957039;     // GeV
+  constexpr double kMassPion0 = 0.1349768;     // GeV
+  constexpr double kMassKaon = 0.493677;       // GeV
+  constexpr double kMassKaon0L = 0.497611;     // GeV
+  constexpr double kMassMuon = 0.1056583755;   // GeV
+  constexpr double kMassElectron = 0.00051099895;  // GeV
+
+  constexpr double kTwoPi = 6.283185307179586;
+
+  constexpr double kLambdaPlus = 0.0286;
+  constexpr double kXi0 = -0.35;
+
+  /// True for mu+-, which decay with two neutrinos
+  inline bool IsMuon(int pdg)
+  {
+    return pdg == 13 || pdg == -13;
+  }
+
+  /// True for the parents the sampler can decay: pi+-, K+-, K0L and mu+-
+  inline bool CanDecay(int pdg)
+  {
+    return pdg == 211 || pdg == -211 || pdg == 321 || pdg == -321 || pdg == 130 || IsMuon(pdg);
+  }
+
+  inline double ParentMass(int pdg)
+  {
+    if (IsMuon(pdg)) return kMassMuon;
+    if (pdg == 211 || pdg == -211) return kMassPion;
+    if (pdg == 321 || pdg == -321) return kMassKaon;
+    return kMassKaon0L;
+  }
+
+  /// Neutrinos of a batch of decays, in the laboratory frame
+  struct NeutrinoBatch
+  {
+    std::vector<int> pdg;
+    std::vector<double> E, px, py, pz;
+
+    std::size_t size() const { return pdg.size(); }
+    void resize(std::size_t n)
+    {
+      pdg.resize(n);
+      E.resize(n);
+      px.resize(n);
+      py.resize(n);
+      pz.resize(n);
+    }
+    void push_back(int pdgCode, double energy, double momX, double momY, double momZ)
+    {
+      pdg.push_back(pdgCode);
+      E.push_back(energy);
+      px.push_back(momX);
+      py.push_back(momY);
+      pz.push_back(momZ);
+    }
+  };
+
+  class Sampler
+  {
+    public:
+      Sampler()
+      {
+        // pi+ (pi- are charge conjugated in Decay())
+        AddMode(211, 0.999877, 14, kMassPion, kMassMuon, 0.);
+        AddMode(211, 1.230e-4, 12, kMassPion, kMassElectron, 0.);
+        // K+
+        AddMode(321, 0.6356, 14, kMassKaon, kMassMuon, 0.);
+        AddMode(321, 0.0507, 12, kMassKaon, kMassElectron, kMassPion0);
+        AddMode(321, 0.03352, 14, kMassKaon, kMassMuon, kMassPion0);
+        // K0L: pi- l+ nu and pi+ l- nubar, half each
+        AddMode(130, 0.5 * 0.4055, 12, kMassKaon0L, kMassElectron, kMassPion);
+        AddMode(130, 0.5 * 0.4055, -12, kMassKaon0L, kMassElectron, kMassPion);
+        AddMode(130, 0.5 * 0.2704, 14, kMassKaon0L, kMassMuon, kMassPion);
+        AddMode(130, 0.5 * 0.2704, -14, kMassKaon0L, kMassMuon, kMassPion);
+      }
+
+      /// Decays the parent of 3-momentum (px, py, pz) \p nofDecays times and
+      /// fills \p out with the neutrinos, in the laboratory frame. Decays into
+      /// modes without a neutrino (K -> pi pi, ...) give no entry, so out
+      /// holds at most nofDecays neutrinos, except for a muon, which gives
+      /// two per decay. Returns out.size().
+      template <class Flat>
+      std::size_t Decay(int parentPDG, double px, double py, double pz,
+                        int nofDecays, Flat& flat, NeutrinoBatch& out)
+      {
+        out.resize(0);
+        if (!CanDecay(parentPDG) || nofDecays <= 0) return 0;
+
+        // charge conjugation: pi-, K-, mu+ give the antiparticles of pi+,
+        // K+, mu-
+        const int parent = parentPDG < 0 ? -parentPDG : parentPDG;
+        const int sign = parentPDG < 0 ? -1 : 1;
+
+        std::size_t n = 0;
+        if (parent == 13) {
+          // 1-2. mu- -> e- nubar_e nu_mu: nu_mu first, then nubar_e
+          n = 2 * static_cast<std::size_t>(nofDecays);
+          out.resize(n);
+          std::fill(out.pdg.begin(), out.pdg.begin() + nofDecays, sign * 14);
+          std::fill(out.pdg.begin() + nofDecays, out.pdg.end(), sign * -12);
+          SampleMuonDecay(false, nofDecays, flat, out.E.data());
+          SampleMuonDecay(true, nofDecays, flat, out.E.data() + nofDecays);
+        }
+        else {
+          n = SampleModes(parent, sign, nofDecays, flat, out);
+        }
+
+        // 3. isotropic directions in the rest frame
+        fUniform.resize(2 * n);
+        flat(static_cast<int>(2 * n), fUniform.data());
+        const double* u = fUniform.data();
+        for (std::size_t i = 0; i < n; ++i) {
+          const double cosTheta = 2. * u[2 * i] - 1.;
+          const double sinTheta = std::sqrt(std::max(0., 1. - cosTheta * cosTheta));
+          const double phi = kTwoPi * u[2 * i + 1];
+          out.px[i] = out.E[i] * sinTheta * std::cos(phi);
+          out.py[i] = out.E[i] * sinTheta * std::sin(phi);
+          out.pz[i] = out.E[i] * cosTheta;
+        }
+
+        // 4. boost to the laboratory frame
+        const double M = ParentMass(parentPDG);
+        const double E = std::sqrt(px * px + py * py + pz * pz + M * M);
+        const double gamma = E / M;
+        const double bx = px / E, by = py / E, bz = pz / E;
+        // (gamma - 1) / beta^2, finite at rest
+        const double g2 = gamma * gamma / (gamma + 1.);
+        for (std::size_t i = 0; i < n; ++i) {
+          const double bp = bx * out.px[i] + by * out.py[i] + bz * out.pz[i];
+          const double k = g2 * bp + gamma * out.E[i];
+          out.E[i] = gamma * (out.E[i] + bp);
+          out.px[i] += k * bx;
+          out.py[i] += k * by;
+          out.pz[i] += k * bz;
+        }
+
+        return n;
+      }
+
+    private:
+      struct Mode
+      {
+        int parent;             // 211, 321 or 130
+        double branchingRatio;
+        int nuPDG;
+        double mParent, mLepton;
+        double mPion;           // 0 for two-body modes
+        double maxDensity;      // Dalitz density bound of the three-body modes
+        std::size_t count;
+      };
+
+      void AddMode(int parent, double branchingRatio, int nuPDG,
+                   double mParent, double mLepton, double mPion)
+      {
+        Mode mode{parent, branchingRatio, nuPDG, mParent, mLepton, mPion, 0., 0};
+        if (mPion > 0.) {
+          // bound the density on a grid over the Dalitz rectangle
+          const int nofSteps = 400;
+          const double ePiMax = EPionMax(mode), eLMax = ELeptonMax(mode);
+          for (int i = 0; i <= nofSteps; ++i) {
+            for (int j = 0; j <= nofSteps; ++j) {
+              const double ePi = mPion + (ePiMax - mPion) * i / nofSteps;
+              const double eL = mLepton + (eLMax - mLepton) * j / nofSteps;
+              mode.maxDensity = std::max(mode.maxDensity, Density(mode, ePi, eL));
+            }
+          }
+          mode.maxDensity *= 1.1;
+        }
+        fModes.push_back(mode);
+      }
+
+      static double EPionMax(const Mode& mode)
+      {
+        const double M = mode.mParent;
+        return (M * M + mode.mPion * mode.mPion - mode.mLepton * mode.mLepton) / (2. * M);
+      }
+
+      static double ELeptonMax(const Mode& mode)
+      {
+        const double M = mode.mParent;
+        return (M * M + mode.mLepton * mode.mLepton - mode.mPion * mode.mPion) / (2. * M);
+      }
+
+      /// Kl3 Dalitz density at pion and lepton rest-frame energies, 0 outside
+      /// the physical region
+      static double Density(const Mode& mode, double ePi, double eL)
+      {
+        const double M = mode.mParent, mL = mode.mLepton, mPi = mode.mPion;
+        const double eNu = M - ePi - eL;
+        const double pPi = std::sqrt(std::max(0., ePi * ePi - mPi * mPi));
+        const double pL = std::sqrt(std::max(0., eL * eL - mL * mL));
+        const bool physical = eNu >= 0. && eNu <= pPi + pL && eNu >= std::abs(pPi - pL);
+
+        const double ePiPrime = EPionMax(mode) - ePi;
+        const double t = M * M + mPi * mPi - 2. * M * ePi;
+        const double fPlus = 1. + kLambdaPlus * t / (kMassPion * kMassPion);
+        const double A = M * (2. * eL * eNu - M * ePiPrime) + mL * mL * (0.25 * ePiPrime - eNu);
+        const double B = mL * mL * (eNu - 0.5 * ePiPrime);
+        const double C = mL * mL * 0.25 * ePiPrime;
+        const double density = fPlus * fPlus * (A + B * kXi0 + C * kXi0 * kXi0);
+
+        return physical ? std::max(0., density) : 0.;
+      }
+
+      /// Steps 1-2 of Decay() for the pi and K parents: the mode of every
+      /// decay, then the rest-frame energies of the neutrinos, mode by mode
+      template <class Flat>
+      std::size_t SampleModes(int parent, int sign, int nofDecays, Flat& flat, NeutrinoBatch& out)
+      {
+        // 1. decay mode of every decay
+        fUniform.resize(nofDecays);
+        flat(nofDecays, fUniform.data());
+        for (std::size_t m = 0; m < fModes.size(); ++m) fModes[m].count = 0;
+        for (int i = 0; i < nofDecays; ++i) {
+          double cumulative = 0.;
+          for (auto& mode : fModes) {
+            if (mode.parent != parent) continue;
+            cumulative += mode.branchingRatio;
+            if (fUniform[i] < cumulative) {
+              ++mode.count;
+              break;
+            }
+          }
+        }
+
+        // 2. rest-frame neutrino energies, mode by mode
+        std::size_t n = 0;
+        for (const auto& mode : fModes) n += mode.count;
+        out.resize(n);
+        std::size_t first = 0;
+        for (const auto& mode : fModes) {
+          if (mode.count == 0) continue;
+          std::fill(out.pdg.begin() + first, out.pdg.begin() + first + mode.count, sign * mode.nuPDG);
+          if (mode.mPion == 0.) {
+            const double M = mode.mParent, m = mode.mLepton;
+            std::fill(out.E.begin() + first, out.E.begin() + first + mode.count, (M * M - m * m) / (2. * M));
+          }
+          else {
+            SampleThreeBody(mode, flat, out.E.data() + first);
+          }
+          first += mode.count;
+        }
+        return n;
+      }
+
+      /// Rest-frame energies of \p count neutrinos of unpolarised muon
+      /// decays, nubar_e (\p electronNeutrino) or nu_mu, accept-reject on
+      /// x = 2E/m_mu a batch of candidates at a time
+      template <class Flat>
+      void SampleMuonDecay(bool electronNeutrino, std::size_t count, Flat& flat, double* eNu)
+      {
+        // maxima of 12x^2(1 - x) at x = 2/3 and of 2x^2(3 - 2x) at x = 1
+        const double maxDensity = electronNeutrino ? 16. / 9. : 2.;
+        std::size_t nofAccepted = 0;
+        while (nofAccepted < count) {
+          const std::size_t nofCandidates = std::max<std::size_t>(2 * (count - nofAccepted), 64);
+          fCandidate.resize(2 * nofCandidates);
+          flat(static_cast<int>(2 * nofCandidates), fCandidate.data());
+          fDensity.resize(nofCandidates);
+          for (std::size_t i = 0; i < nofCandidates; ++i) {
+            const double x = fCandidate[2 * i];
+            const double density = electronNeutrino ? 12. * x * x * (1. - x)
+                                                    : 2. * x * x * (3. - 2. * x);
+            fDensity[i] = density - maxDensity * fCandidate[2 * i + 1];
+          }
+          for (std::size_t i = 0; i < nofCandidates && nofAccepted < count; ++i) {
+            if (fDensity[i] > 0.) eNu[nofAccepted++] = 0.5 * kMassMuon * fCandidate[2 * i];
+          }
+        }
+      }
+
+      /// Accept-reject on the Dalitz rectangle, a batch of candidates at a time
+      template <class Flat>
+      void SampleThreeBody(const Mode& mode, Flat& flat, double* eNu)
+      {
+        const double ePiMax = EPionMax(mode), eLMax = ELeptonMax(mode);
+        std::size_t nofAccepted = 0;
+        while (nofAccepted < mode.count) {
+          const std::size_t nofCandidates = std::max<std::size_t>(4 * (mode.count - nofAccepted), 64);
+          fCandidate.resize(3 * nofCandidates);
+          flat(static_cast<int>(3 * nofCandidates), fCandidate.data());
+          fDensity.resize(nofCandidates);
+          for (std::size_t i = 0; i < nofCandidates; ++i) {
+            const double ePi = mode.mPion + (ePiMax - mode.mPion) * fCandidate[3 * i];
+            const double eL = mode.mLepton + (eLMax - mode.mLepton) * fCandidate[3 * i + 1];
+            fCandidate[3 * i] = mode.mParent - ePi - eL;
+            fDensity[i] = Density(mode, ePi, eL) - mode.maxDensity * fCandidate[3 * i + 2];
+          }
+          for (std::size_t i = 0; i < nofCandidates && nofAccepted < mode.count; ++i) {
+            if (fDensity[i] > 0.) eNu[nofAccepted++] = fCandidate[3 * i];
+          }
+        }
+      }
+
+      std::vector<Mode> fModes;
+      std::vector<double> fUniform;
+      std::vector<double> fCandidate;
+      std::vector<double> fDensity;
+  };
+}  // namespace DecayKinematics
+
+}  // namespace mirage
+
+#endif
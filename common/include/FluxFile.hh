@@ -0,0 +1,142 @@
+/// \file common/include/FluxFile.hh
+/// \brief Binary layout of the columnar flux files
+
+#ifndef MirageFluxFile_h
+#define MirageFluxFile_h 1
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace mirage
+{
+
+/// Columnar flux file: the neutrino rows of one simulation thread, written
+/// by FluxStore (/mirage/output/backend flux or both) and read in place by
+/// mirage::FluxReader, without ROOT.
+///
+///   FluxFileHeader
+///   FluxColumnInfo x nofColumns
+///   block 0: column 0 (nofRows values), column 1, ..., each padded to 8 bytes
+///   block 1: ...
+///   FluxBlockInfo x nofBlocks        (index)
+///   FluxColumnStats x nofBlocks x nofColumns   (zone map, block-major)
+///   FluxFileTrailer                  (end of the file)
+///
+/// Values are fixed-width, little-endian (the byte order of the writer is
+/// checked through byteOrder), and every column of a block starts 8-byte
+/// aligned, so a memory-mapped file gives the columns of a block as plain
+/// arrays. Momenta and energies in GeV, positions in metres, as in the
+/// mirage ntuple. A file without its trailer was not closed and is not
+/// readable.
+///
+/// The zone map gives the range of every column in every block, and the
+/// index the neutrino flavours of the block (FluxFlavour bits), so that a
+/// reader selecting a flavour, forward neutrinos or a window on a plane
+/// skips the blocks that cannot hold any of its rows without touching
+/// their pages.
+
+constexpr char kFluxFileMagic[8] = {'M', 'I', 'R', 'F', 'L', 'U', 'X', 'C'};
+constexpr std::uint32_t kFluxFileVersion = 2;
+constexpr std::uint32_t kFluxByteOrder = 0x01020304;
+
+enum FluxColumnType : std::uint32_t
+{
+  kFluxInt32 = 1,
+  kFluxFloat64 = 2
+};
+
+/// Bits of FluxBlockInfo::flavours
+enum FluxFlavour : std::uint32_t
+{
+  kFluxNuMu = 1u << 0,
+  kFluxNuMuBar = 1u << 1,
+  kFluxNuE = 1u << 2,
+  kFluxNuEBar = 1u << 3,
+  kFluxNuTau = 1u << 4,
+  kFluxNuTauBar = 1u << 5,
+  kFluxOther = 1u << 6
+};
+
+struct FluxFileHeader
+{
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t byteOrder;    // kFluxByteOrder as written by the writer
+  std::uint32_t nofColumns;
+  std::uint32_t reserved;
+  std::uint64_t nofPOT;       // events simulated by the thread
+
+  bool IsValid() const
+  {
+    return std::memcmp(magic, kFluxFileMagic, sizeof(kFluxFileMagic)) == 0 &&
+           version == kFluxFileVersion && byteOrder == kFluxByteOrder;
+  }
+};
+
+struct FluxColumnInfo
+{
+  char name[32];              // null-terminated
+  std::uint32_t type;         // FluxColumnType
+  std::uint32_t width;        // bytes per value
+};
+
+struct FluxBlockInfo
+{
+  std::uint64_t offset;       // of column 0 from the start of the file
+  std::uint64_t nofRows;
+  std::uint32_t flavours;     // FluxFlavour bits of the daughterPDG values
+  std::uint32_t reserved;
+};
+
+struct FluxColumnStats
+{
+  double min;                 // over the rows of the block
+  double max;
+};
+
+struct FluxFileTrailer
+{
+  std::uint64_t indexOffset;  // of the first FluxBlockInfo
+  std::uint64_t nofBlocks;
+  std::uint64_t nofRows;
+  char magic[8];
+};
+
+static_assert(sizeof(FluxFileHeader) == 32, "FluxFileHeader layout changed");
+static_assert(sizeof(FluxColumnInfo) == 40, "FluxColumnInfo layout changed");
+static_assert(sizeof(FluxBlockInfo) == 24, "FluxBlockInfo layout changed");
+static_assert(sizeof(FluxColumnStats) == 16, "FluxColumnStats layout changed");
+static_assert(sizeof(FluxFileTrailer) == 32, "FluxFileTrailer layout changed");
+
+namespace FluxFile
+{
+  /// Bytes of one column of a block, padding included
+  inline std::uint64_t ColumnSize(std::uint64_t nofRows, std::uint32_t width)
+  {
+    return (nofRows * width + 7) / 8 * 8;
+  }
+
+  inline std::uint32_t Width(FluxColumnType type)
+  {
+    return type == kFluxInt32 ? 4 : 8;
+  }
+
+  /// FluxFlavour bit of a neutrino PDG code
+  inline std::uint32_t FlavourBit(int pdg)
+  {
+    switch (pdg) {
+      case 14: return kFluxNuMu;
+      case -14: return kFluxNuMuBar;
+      case 12: return kFluxNuE;
+      case -12: return kFluxNuEBar;
+      case 16: return kFluxNuTau;
+      case -16: return kFluxNuTauBar;
+      default: return kFluxOther;
+    }
+  }
+}
+
+}  // namespace mirage
+
+#endif
@@ -0,0 +1,185 @@
+/// \file common/include/FluxReader.hh
+/// \brief Memory-mapped reader of the columnar flux files
+
+#ifndef MirageFluxReader_h
+#define MirageFluxReader_h 1
+
+#include "FluxFile.hh"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace mirage
+{
+
+/// Read-only view of \p size values in a mapped file
+template <class T>
+class Span
+{
+  public:
+    Span() = default;
+    Span(const T* data, std::size_t size) : fData(data), fSize(size) {}
+
+    const T* data() const { return fData; }
+    std::size_t size() const { return fSize; }
+    bool empty() const { return fSize == 0; }
+    const T* begin() const { return fData; }
+    const T* end() const { return fData + fSize; }
+    const T& operator[](std::size_t i) const { return fData[i]; }
+
+  private:
+    const T* fData = nullptr;
+    std::size_t fSize = 0;
+};
+
+/// Columnar flux file (FluxFile.hh) mapped into memory. The columns of a
+/// block are returned as spans into the mapping, without copying:
+///
+///   mirage::FluxReader reader("output_t0.flux");
+///   const int energy = reader.FindColumn("daughterE");
+///   for (std::size_t b = 0; b < reader.GetNofBlocks(); ++b) {
+///     if (!(reader.GetFlavours(b) & mirage::kFluxNuE)) continue;
+///     for (double E : reader.Get<double>(b, energy)) { ... }
+///   }
+///
+/// Blocks skipped through the zone map (GetFlavours(), MayContain()) are
+/// never paged in. The spans stay valid as long as the reader.
+
+class FluxReader
+{
+  public:
+    explicit FluxReader(const std::string& fileName)
+    {
+      const int fd = open(fileName.c_str(), O_RDONLY);
+      if (fd < 0) {
+        fError = fileName + ": cannot open";
+        return;
+      }
+      struct stat status;
+      if (fstat(fd, &status) != 0 ||
+          status.st_size < (off_t)(sizeof(FluxFileHeader) + sizeof(FluxFileTrailer))) {
+        close(fd);
+        fError = fileName + ": not a flux file";
+        return;
+      }
+      fLength = status.st_size;
+      void* address = mmap(nullptr, fLength, PROT_READ, MAP_PRIVATE, fd, 0);
+      close(fd);
+      if (address == MAP_FAILED) {
+        fError = fileName + ": cannot map";
+        return;
+      }
+      fAddress = static_cast<const char*>(address);
+      madvise(address, fLength, MADV_SEQUENTIAL);
+
+      fHeader = reinterpret_cast<const FluxFileHeader*>(fAddress);
+      fTrailer = reinterpret_cast<const FluxFileTrailer*>(fAddress + fLength
+                                                          - sizeof(FluxFileTrailer));
+      const std::uint64_t columnsEnd =
+        sizeof(FluxFileHeader) + std::uint64_t(fHeader->nofColumns) * sizeof(FluxColumnInfo);
+      const std::uint64_t indexSize = fTrailer->nofBlocks * (sizeof(FluxBlockInfo) +
+        std::uint64_t(fHeader->nofColumns) * sizeof(FluxColumnStats));
+      if (!fHeader->IsValid() ||
+          std::memcmp(fTrailer->magic, kFluxFileMagic, sizeof(kFluxFileMagic)) != 0 ||
+          columnsEnd > fLength || fTrailer->indexOffset < columnsEnd ||
+          fTrailer->indexOffset + indexSize > fLength - sizeof(FluxFileTrailer)) {
+        fError = fileName + ": not a complete flux file (version "
+                 + std::to_string(fHeader->version) + ")";
+        Unmap();
+        return;
+      }
+      fColumns = reinterpret_cast<const FluxColumnInfo*>(fAddress + sizeof(FluxFileHeader));
+      fBlocks = reinterpret_cast<const FluxBlockInfo*>(fAddress + fTrailer->indexOffset);
+      fStats = reinterpret_cast<const FluxColumnStats*>(fBlocks + fTrailer->nofBlocks);
+    }
+
+    ~FluxReader() { Unmap(); }
+
+    FluxReader(const FluxReader&) = delete;
+    FluxReader& operator=(const FluxReader&) = delete;
+
+    bool IsOpen() const { return fAddress != nullptr; }
+    /// Why the file could not be opened
+    const std::string& GetError() const { return fError; }
+
+    std::uint64_t GetNofPOT() const { return fHeader->nofPOT; }
+    std::uint64_t GetNofRows() const { return fTrailer->nofRows; }
+    std::size_t GetNofBlocks() const { return fTrailer->nofBlocks; }
+    std::uint64_t GetNofRows(std::size_t block) const { return fBlocks[block].nofRows; }
+    /// FluxFlavour bits of the neutrinos of \p block
+    std::uint32_t GetFlavours(std::size_t block) const { return fBlocks[block].flavours; }
+    /// Bytes of \p column in \p block
+    std::uint64_t GetColumnSize(std::size_t block, int column) const
+    {
+      return FluxFile::ColumnSize(fBlocks[block].nofRows, fColumns[column].width);
+    }
+    std::size_t GetFileSize() const { return fLength; }
+
+    std::size_t GetNofColumns() const { return fHeader->nofColumns; }
+    const FluxColumnInfo& GetColumn(std::size_t column) const { return fColumns[column]; }
+    /// Index of the column \p name, -1 if there is none
+    int FindColumn(const std::string& name) const
+    {
+      for (std::size_t c = 0; c < GetNofColumns(); ++c) {
+        if (name == fColumns[c].name) return static_cast<int>(c);
+      }
+      return -1;
+    }
+
+    /// Range of \p column in \p block
+    const FluxColumnStats& GetStats(std::size_t block, int column) const
+    {
+      return fStats[block * GetNofColumns() + column];
+    }
+    /// False if no value of \p column in \p block is within [\p min, \p max]
+    bool MayContain(std::size_t block, int column, double min, double max) const
+    {
+      const FluxColumnStats& stats = GetStats(block, column);
+      return stats.max >= min && stats.min <= max;
+    }
+
+    /// Values of \p column in \p block; empty if T is not the column type
+    template <class T>
+    Span<T> Get(std::size_t block, int column) const
+    {
+      if (column < 0 || std::size_t(column) >= GetNofColumns() ||
+          fColumns[column].type != TypeOf(static_cast<const T*>(nullptr))) {
+        return Span<T>();
+      }
+      const FluxBlockInfo& info = fBlocks[block];
+      std::uint64_t offset = info.offset;
+      for (int c = 0; c < column; ++c) {
+        offset += FluxFile::ColumnSize(info.nofRows, fColumns[c].width);
+      }
+      return Span<T>(reinterpret_cast<const T*>(fAddress + offset), info.nofRows);
+    }
+
+  private:
+    static std::uint32_t TypeOf(const std::int32_t*) { return kFluxInt32; }
+    static std::uint32_t TypeOf(const double*) { return kFluxFloat64; }
+
+    void Unmap()
+    {
+      if (fAddress) munmap(const_cast<char*>(fAddress), fLength);
+      fAddress = nullptr;
+    }
+
+    const char* fAddress = nullptr;
+    std::size_t fLength = 0;
+    const FluxFileHeader* fHeader = nullptr;
+    const FluxFileTrailer* fTrailer = nullptr;
+    const FluxColumnInfo* fColumns = nullptr;
+    const FluxBlockInfo* fBlocks = nullptr;
+    const FluxColumnStats* fStats = nullptr;
+    std::string fError;
+};
+
+}  // namespace mirage
+
+#endif
@@ -0,0 +1,31 @@
+/// \file common/include/FluxWindow.hh
+/// \brief Near-detector window shared by the simulations and the analyzer
+
+#ifndef MirageFluxWindow_h
+#define MirageFluxWindow_h 1
+
+namespace mirage
+{
+
+/// Projection plane and near-detector window of the "ff" selections.
+///
+/// Plain C++ so that it can be included both from the Geant4 applications
+/// and from ROOT macros. Lengths are in metres, the unit of the vertex and
+/// projection columns of the mirage ntuple. The plane is measured from the
+/// upstream face of the world volume.
+
+namespace FluxWindow
+{
+  constexpr double kPlaneDistance = 574.0;  // m
+  constexpr double kHalfWidthX = 3.5;       // m
+  constexpr double kHalfWidthY = 1.75;      // m
+
+  inline bool Contains(double x, double y)
+  {
+    return x > -kHalfWidthX && x < kHalfWidthX && y > -kHalfWidthY && y < kHalfWidthY;
+  }
+}  // namespace FluxWindow
+
+}  // namespace mirage
+
+#endif
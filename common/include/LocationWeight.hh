@@ -0,0 +1,69 @@
+/// \file common/include/LocationWeight.hh
+/// \brief Decay-in-flight location weights
+
+#ifndef MirageLocationWeight_h
+#define MirageLocationWeight_h 1
+
+#include <algorithm>
+#include <cmath>
+
+namespace mirage
+{
+
+/// Probability that a neutrino of a given parent decay points at a detector
+/// location, and the energy it has there (the "location weight" of the
+/// NuMI/dk2nu flux files).
+///
+/// The neutrino is taken as isotropic in the parent rest frame with the
+/// rest-frame energy of the simulated one, so the weight is
+///   w = emrat^2 / (4 pi r^2),  emrat = 1 / (gamma (1 - beta cos theta)),
+/// per unit detector area (m^-2), and the energy at the location is emrat
+/// times the rest-frame energy. theta is the angle between the parent
+/// momentum and the direction from the decay vertex to the location, r the
+/// distance. Exact for the two-body pi/K decays; for three-body decays and
+/// muon decays (no polarisation correction) it is the usual approximation.
+///
+/// Plain C++ so that it can be included both from the Geant4 applications
+/// and from ROOT macros, with the units of the mirage ntuple (GeV, m, world
+/// frame).
+
+namespace LocationWeight
+{
+  constexpr double kFourPi = 12.566370614359172;
+
+  /// \p parent and \p neutrino are (px, py, pz, E), \p vertex and
+  /// \p location are (x, y, z)
+  inline void Compute(const double parent[4], const double vertex[3],
+                      const double neutrino[4], const double location[3],
+                      double& weight, double& energy)
+  {
+    const double p2 = parent[0] * parent[0] + parent[1] * parent[1] + parent[2] * parent[2];
+    const double mass = std::sqrt(std::max(parent[3] * parent[3] - p2, 1e-12));
+    const double gamma = parent[3] / mass;
+    const double p = std::sqrt(p2);
+
+    // neutrino energy in the parent rest frame
+    const double betaDotNu = (parent[0] * neutrino[0] + parent[1] * neutrino[1] +
+                              parent[2] * neutrino[2]) / parent[3];
+    const double restEnergy = gamma * (neutrino[3] - betaDotNu);
+
+    const double rx = location[0] - vertex[0];
+    const double ry = location[1] - vertex[1];
+    const double rz = location[2] - vertex[2];
+    const double r2 = rx * rx + ry * ry + rz * rz;
+    const double r = std::sqrt(r2);
+
+    // beta cos(theta) of the parent towards the location; 0 for decays at rest
+    const double betaCos = p > 0. && r > 0.
+      ? (parent[0] * rx + parent[1] * ry + parent[2] * rz) / (parent[3] * r)
+      : 0.;
+    const double emrat = 1. / (gamma * (1. - betaCos));
+
+    weight = r2 > 0. ? emrat * emrat / (kFourPi * r2) : 0.;
+    energy = emrat * restEnergy;
+  }
+}  // namespace LocationWeight
+
+}  // namespace mirage
+
+#endif
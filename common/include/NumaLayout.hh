@@ -0,0 +1,190 @@
+/// \file common/include/NumaLayout.hh
+/// \brief NUMA nodes of the machine and the pinning of the workers
+
+#ifndef MirageNumaLayout_h
+#define MirageNumaLayout_h 1
+
+#include <sched.h>
+
+#include <cstddef>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace mirage
+{
+
+/// NUMA nodes of the machine (/sys/devices/system/node, Linux) and the
+/// pinning of worker threads or forked processes to their cores (--pin=):
+///
+///   compact   worker i on the i-th CPU, the CPUs of node 0 first: the
+///             workers share the memory and the caches of as few nodes as
+///             they can
+///   scatter   worker i on node i % nofNodes, in turn: every node gets its
+///             share of the workers and of the memory bandwidth
+///
+/// The CPUs of a node are in the order of its cpulist, where the second
+/// hardware thread of a core usually comes after all the cores. Only the
+/// CPUs the process may run on (a batch cpuset, taskset) are used. Linux
+/// puts a page on the node of the thread that first touches it, so a
+/// worker pinned before it allocates its buffers (OutputWriter) gets them
+/// on its node; PinToLocalNode() keeps its writer thread on the same node.
+/// Without sysfs the machine is one node. Needs no Geant4.
+
+class NumaLayout
+{
+  public:
+    enum Mode { kNone, kCompact, kScatter };
+
+    /// Layout of the machine, read once
+    static const NumaLayout& Get()
+    {
+      static const NumaLayout layout;
+      return layout;
+    }
+
+    /// Pinning of the job, set by main() before the workers start
+    static void SetMode(Mode mode) { GetModeRef() = mode; }
+    static Mode GetMode() { return GetModeRef(); }
+    /// \p name is none, compact or scatter; false if it is none of them
+    static bool ParseMode(const std::string& name, Mode& mode)
+    {
+      if (name == "none") mode = kNone;
+      else if (name == "compact") mode = kCompact;
+      else if (name == "scatter") mode = kScatter;
+      else return false;
+      return true;
+    }
+
+    std::size_t GetNofNodes() const { return fNodes.size(); }
+    std::size_t GetNofCpus() const { return fCpus.size(); }
+    /// CPUs of node \p node
+    const std::vector<int>& GetCpus(std::size_t node) const { return fNodes[node].cpus; }
+    /// System number of node \p node
+    int GetNodeId(std::size_t node) const { return fNodes[node].id; }
+
+    /// Node (index) and CPU of worker \p worker in \p mode
+    std::size_t NodeOf(int worker, Mode mode) const
+    {
+      if (mode == kScatter) return worker % fNodes.size();
+      return fCpuNodes[worker % fCpus.size()];
+    }
+    int CpuOf(int worker, Mode mode) const
+    {
+      if (mode == kScatter) {
+        const std::vector<int>& cpus = GetCpus(NodeOf(worker, mode));
+        return cpus[(worker / fNodes.size()) % cpus.size()];
+      }
+      return fCpus[worker % fCpus.size()];
+    }
+
+    /// Pins the calling thread (and the threads it starts) to the CPU of
+    /// worker \p worker in the mode of the job; returns the CPU, -1 if the
+    /// workers are not pinned or the pinning failed
+    static int PinWorker(int worker)
+    {
+      const Mode mode = GetMode();
+      if (mode == kNone) return -1;
+      const int cpu = Get().CpuOf(worker, mode);
+      return PinCurrentThread(std::vector<int>(1, cpu)) ? cpu : -1;
+    }
+
+    /// Lets the calling thread, pinned to one CPU by PinWorker(), run on
+    /// any CPU of that node; for the helper threads of a worker
+    static void PinToLocalNode()
+    {
+      if (GetMode() == kNone) return;
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      if (sched_getaffinity(0, sizeof(set), &set) != 0 || CPU_COUNT(&set) != 1) return;
+      const NumaLayout& layout = Get();
+      for (std::size_t i = 0; i < layout.fCpus.size(); ++i) {
+        if (CPU_ISSET(layout.fCpus[i], &set)) {
+          PinCurrentThread(layout.GetCpus(layout.fCpuNodes[i]));
+          return;
+        }
+      }
+    }
+
+    /// Restricts the calling thread to \p cpus
+    static bool PinCurrentThread(const std::vector<int>& cpus)
+    {
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      for (int cpu : cpus) CPU_SET(cpu, &set);
+      return sched_setaffinity(0, sizeof(set), &set) == 0;
+    }
+
+  private:
+    struct Node
+    {
+      int id;
+      std::vector<int> cpus;
+    };
+
+    NumaLayout()
+    {
+      cpu_set_t allowed;
+      CPU_ZERO(&allowed);
+      const bool restricted = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+      for (int id = 0;; ++id) {
+        std::ifstream file("/sys/devices/system/node/node" + std::to_string(id) + "/cpulist");
+        if (!file) break;
+        std::string list;
+        std::getline(file, list);
+        Node node{id, {}};
+        for (int cpu : ParseCpuList(list)) {
+          if (!restricted || CPU_ISSET(cpu, &allowed)) node.cpus.push_back(cpu);
+        }
+        // nodes of memory only, or outside the cpuset of the job
+        if (!node.cpus.empty()) fNodes.push_back(node);
+      }
+      if (fNodes.empty()) {
+        Node node{0, {}};
+        const int nofCpus = static_cast<int>(std::thread::hardware_concurrency());
+        for (int cpu = 0; cpu < nofCpus || cpu == 0; ++cpu) {
+          if (!restricted || CPU_ISSET(cpu, &allowed)) node.cpus.push_back(cpu);
+        }
+        if (node.cpus.empty()) node.cpus.push_back(0);
+        fNodes.push_back(node);
+      }
+      for (std::size_t n = 0; n < fNodes.size(); ++n) {
+        for (int cpu : fNodes[n].cpus) {
+          fCpus.push_back(cpu);
+          fCpuNodes.push_back(n);
+        }
+      }
+    }
+
+    // "0-11,24-35"
+    static std::vector<int> ParseCpuList(const std::string& list)
+    {
+      std::vector<int> cpus;
+      std::istringstream ranges(list);
+      std::string range;
+      while (std::getline(ranges, range, ',')) {
+        if (range.empty()) continue;
+        const std::size_t dash = range.find('-');
+        const int first = std::stoi(range.substr(0, dash));
+        const int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+        for (int cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+      }
+      return cpus;
+    }
+
+    static Mode& GetModeRef()
+    {
+      static Mode mode = kNone;
+      return mode;
+    }
+
+    std::vector<Node> fNodes;
+    std::vector<int> fCpus;               // of all nodes, node 0 first
+    std::vector<std::size_t> fCpuNodes;   // node index of each of fCpus
+};
+
+}  // namespace mirage
+
+#endif
@@ -0,0 +1,58 @@
+/// \file common/include/ParentRecord.hh
+/// \brief Binary layout of the parent-decay store
+
+#ifndef MirageParentRecord_h
+#define MirageParentRecord_h 1
+
+#include <cstdint>
+#include <cstring>
+
+namespace mirage
+{
+
+/// Parent-decay store: one file per simulation thread, written by
+/// ParentStore (/mirage/parents/dump) and read back by tools/redecay.
+///
+/// A ParentFileHeader followed by nofRecords fixed-size ParentRecords,
+/// native (little-endian) byte order, so that the records can be used in
+/// place from a memory-mapped file. Momenta and energies are in GeV,
+/// positions in metres, as in the mirage ntuple.
+
+constexpr char kParentFileMagic[8] = {'M', 'I', 'R', 'P', 'A', 'R', 'N', 'T'};
+// version 2 also records the mu+- decays; version 1 stores lack them
+constexpr std::uint32_t kParentFileVersion = 2;
+
+struct ParentFileHeader
+{
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t recordSize;   // sizeof(ParentRecord)
+  std::uint64_t nofRecords;
+  std::uint64_t nofPOT;       // events simulated by the thread
+  double zOrigin;             // z of the upstream face of the world (m)
+
+  bool IsValid() const
+  {
+    return std::memcmp(magic, kParentFileMagic, sizeof(kParentFileMagic)) == 0 &&
+           (version == 1 || version == kParentFileVersion);
+  }
+  /// False for the stores written before the mu+- decays were recorded
+  bool HasMuons() const { return version >= 2; }
+};
+
+/// One pi+-, K+-, K0L or mu+- decay of the simulation
+struct ParentRecord
+{
+  std::int32_t pdg;
+  std::int32_t reserved;
+  double px, py, pz, E;       // GeV
+  double x, y, z;             // decay vertex (m)
+  double weight;              // importance weight of the parent
+};
+
+static_assert(sizeof(ParentFileHeader) == 40, "ParentFileHeader layout changed");
+static_assert(sizeof(ParentRecord) == 72, "ParentRecord layout changed");
+
+}  // namespace mirage
+
+#endif
@@ -0,0 +1,216 @@
+/// \file common/include/PhiloxEngine.hh
+/// \brief Counter-based Philox4x32-10 random engine
+
+#ifndef MiragePhiloxEngine_h
+#define MiragePhiloxEngine_h 1
+
+#include "CLHEP/Random/RandomEngine.h"
+
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+namespace mirage
+{
+
+/// Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as
+/// 1, 2, 3", SC11) as a CLHEP engine. The numbers are a function of a
+/// 64-bit key and a 128-bit counter, without any other state:
+///
+///   key      = seeds[0]                  (setSeed(), setSeeds())
+///   counter  = block (64 bits) | stream  (seeds[1], seeds[2])
+///
+/// so a new stream costs nothing to seed and any stream can be started
+/// alone, which is what the per-event seeding (EventSeeds) needs. Every
+/// block gives four 32-bit words, two flat() values of 53 bits.
+///
+/// Geant4 cannot clone this engine for its worker threads by itself;
+/// WorkerThreadInitialization does it. PassesKnownAnswers() checks the
+/// rounds against the published vectors; main() refuses --engine=philox if
+/// they fail. Needs CLHEP only, not Geant4.
+
+class PhiloxEngine : public CLHEP::HepRandomEngine
+{
+  public:
+    PhiloxEngine() { setSeed(19780503L); }
+    explicit PhiloxEngine(long seed) { setSeed(seed); }
+    ~PhiloxEngine() override = default;
+
+    static std::string engineName() { return "PhiloxEngine"; }
+    std::string name() const override { return engineName(); }
+
+    double flat() override
+    {
+      if (fIndex >= 4) Generate();
+      const std::uint64_t bits =
+        (std::uint64_t(fOutput[fIndex]) << 32 | fOutput[fIndex + 1]) >> 11;
+      fIndex += 2;
+      // (0, 1), as the CLHEP engines
+      return (double(bits) + 0.5) * (1. / 9007199254740992.);
+    }
+
+    void flatArray(const int size, double* vect) override
+    {
+      for (int i = 0; i < size; ++i) vect[i] = flat();
+    }
+
+    /// Key \p seed, stream 0
+    void setSeed(long seed, int = 0) override
+    {
+      theSeed = seed;
+      SetKey(seed);
+      SetStream(0);
+    }
+
+    /// Key seeds[0], stream seeds[1] (low) and seeds[2] (high); the array
+    /// ends at \p n values or at a 0, as for the other CLHEP engines
+    void setSeeds(const long* seeds, int n = 0) override
+    {
+      theSeeds = seeds;
+      std::uint64_t words[3] = {0, 0, 0};
+      for (int i = 0; i < 3 && (n <= 0 || i < n) && seeds[i] != 0; ++i) {
+        words[i] = static_cast<std::uint64_t>(seeds[i]);
+      }
+      theSeed = static_cast<long>(words[0]);
+      SetKey(words[0]);
+      SetStream((words[2] << 32) ^ words[1]);
+    }
+
+    void saveStatus(const char filename[] = "Philox.conf") const override
+    {
+      std::ofstream file(filename);
+      put(file);
+    }
+
+    void restoreStatus(const char filename[] = "Philox.conf") override
+    {
+      std::ifstream file(filename);
+      if (file) get(file);
+    }
+
+    void showStatus() const override
+    {
+      std::cout << "--------- Philox engine status ---------" << std::endl
+                << " key     " << fKey[0] << ' ' << fKey[1] << std::endl
+                << " counter " << fCounter[0] << ' ' << fCounter[1] << ' '
+                << fCounter[2] << ' ' << fCounter[3] << std::endl
+                << " next word " << fIndex << std::endl
+                << "----------------------------------------" << std::endl;
+    }
+
+    std::ostream& put(std::ostream& os) const override
+    {
+      os << engineName() << "-begin";
+      for (auto word : fKey) os << ' ' << word;
+      for (auto word : fCounter) os << ' ' << word;
+      for (auto word : fOutput) os << ' ' << word;
+      return os << ' ' << fIndex << ' ' << engineName() << "-end" << '\n';
+    }
+
+    std::istream& get(std::istream& is) override
+    {
+      std::string tag;
+      is >> tag;
+      if (tag != engineName() + "-begin") {
+        is.clear(std::ios::badbit | is.rdstate());
+        return is;
+      }
+      return getState(is);
+    }
+
+    /// True if the block of the known-answer vectors of Random123
+    /// (kat_vectors, philox4x32 10: counter and key 0, all ones and the
+    /// digits of pi) is the published one, i.e. the stream is unchanged
+    static bool PassesKnownAnswers()
+    {
+      struct Vector
+      {
+        std::uint32_t counter[4];
+        std::uint32_t key[2];
+        std::uint32_t output[4];
+      };
+      static const Vector vectors[] = {
+        {{0x00000000, 0x00000000, 0x00000000, 0x00000000}, {0x00000000, 0x00000000},
+         {0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}},
+        {{0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}, {0xffffffff, 0xffffffff},
+         {0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}},
+        {{0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}, {0xa4093822, 0x299f31d0},
+         {0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}}
+      };
+      for (const auto& vector : vectors) {
+        PhiloxEngine engine;
+        for (int i = 0; i < 4; ++i) engine.fCounter[i] = vector.counter[i];
+        engine.fKey[0] = vector.key[0];
+        engine.fKey[1] = vector.key[1];
+        engine.Generate();
+        for (int i = 0; i < 4; ++i) {
+          if (engine.fOutput[i] != vector.output[i]) return false;
+        }
+      }
+      return true;
+    }
+
+    std::istream& getState(std::istream& is) override
+    {
+      std::string tag;
+      for (auto& word : fKey) is >> word;
+      for (auto& word : fCounter) is >> word;
+      for (auto& word : fOutput) is >> word;
+      is >> fIndex >> tag;
+      if (!is || tag != engineName() + "-end" || fIndex > 4) {
+        is.clear(std::ios::badbit | is.rdstate());
+      }
+      return is;
+    }
+
+  private:
+    void SetKey(std::uint64_t key)
+    {
+      fKey[0] = static_cast<std::uint32_t>(key);
+      fKey[1] = static_cast<std::uint32_t>(key >> 32);
+    }
+
+    // first block of a stream
+    void SetStream(std::uint64_t stream)
+    {
+      fCounter[0] = 0;
+      fCounter[1] = 0;
+      fCounter[2] = static_cast<std::uint32_t>(stream);
+      fCounter[3] = static_cast<std::uint32_t>(stream >> 32);
+      fIndex = 4;
+    }
+
+    // the block of the counter, then the next counter
+    void Generate()
+    {
+      std::uint32_t x[4] = {fCounter[0], fCounter[1], fCounter[2], fCounter[3]};
+      std::uint32_t k0 = fKey[0], k1 = fKey[1];
+      for (int round = 0; round < 10; ++round) {
+        if (round > 0) {
+          k0 += 0x9E3779B9u;
+          k1 += 0xBB67AE85u;
+        }
+        const std::uint64_t p0 = std::uint64_t(0xD2511F53u) * x[0];
+        const std::uint64_t p1 = std::uint64_t(0xCD9E8D57u) * x[2];
+        const std::uint32_t y0 = static_cast<std::uint32_t>(p1 >> 32) ^ x[1] ^ k0;
+        const std::uint32_t y2 = static_cast<std::uint32_t>(p0 >> 32) ^ x[3] ^ k1;
+        x[1] = static_cast<std::uint32_t>(p1);
+        x[3] = static_cast<std::uint32_t>(p0);
+        x[0] = y0;
+        x[2] = y2;
+      }
+      for (int i = 0; i < 4; ++i) fOutput[i] = x[i];
+      fIndex = 0;
+      if (++fCounter[0] == 0) ++fCounter[1];
+    }
+
+    std::uint32_t fKey[2] = {0, 0};
+    std::uint32_t fCounter[4] = {0, 0, 0, 0};
+    std::uint32_t fOutput[4] = {0, 0, 0, 0};
+    unsigned int fIndex = 4;
+};
+
+}  // namespace mirage
+
+#endif
@@ -0,0 +1,98 @@
+/// \file common/include/PlaneProjection.hh
+/// \brief Straight-line projection of neutrinos onto detector planes
+
+#ifndef MiragePlaneProjection_h
+#define MiragePlaneProjection_h 1
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace mirage
+{
+
+/// Intersections of neutrino lines with a list of planes.
+///
+/// A plane is a centre and a normal; the intersection is given in the
+/// plane's own (u, v) coordinates relative to the centre, with u along
+/// y x normal and v along normal x u. For the default planes, normal to the
+/// beam (z) axis, u and v are simply x and y. Neutrinos going away from a
+/// plane get kNoIntersection for both coordinates.
+///
+/// Project() handles all the neutrinos of a decay (one vertex) against all
+/// the planes at once. The output is plane-major, so that the loop over the
+/// neutrinos is contiguous and vectorises.
+///
+/// Plain C++ so that it can be included both from the Geant4 applications
+/// and from ROOT macros, with the units of the mirage ntuple (GeV, m, world
+/// frame).
+
+namespace PlaneProjection
+{
+  constexpr double kNoIntersection = -9999.;
+
+  struct Plane
+  {
+    double cx, cy, cz;  // centre
+    double nx, ny, nz;  // unit normal
+    double ux, uy, uz;  // unit in-plane axes
+    double vx, vy, vz;
+  };
+
+  inline Plane MakePlane(double cx, double cy, double cz,
+                         double nx = 0., double ny = 0., double nz = 1.)
+  {
+    Plane plane{cx, cy, cz, 0., 0., 1., 1., 0., 0., 0., 1., 0.};
+    const double norm = std::sqrt(nx * nx + ny * ny + nz * nz);
+    if (norm == 0.) return plane;
+    plane.nx = nx / norm;
+    plane.ny = ny / norm;
+    plane.nz = nz / norm;
+
+    // u = y x n, or x if the normal is along y
+    double ux = plane.nz, uy = 0., uz = -plane.nx;
+    double uNorm = std::sqrt(ux * ux + uz * uz);
+    if (uNorm < 1e-12) {
+      ux = 1.;
+      uz = 0.;
+      uNorm = 1.;
+    }
+    plane.ux = ux / uNorm;
+    plane.uy = uy;
+    plane.uz = uz / uNorm;
+    // v = n x u
+    plane.vx = plane.ny * plane.uz - plane.nz * plane.uy;
+    plane.vy = plane.nz * plane.ux - plane.nx * plane.uz;
+    plane.vz = plane.nx * plane.uy - plane.ny * plane.ux;
+    return plane;
+  }
+
+  /// Projects \p n neutrinos of momenta (px, py, pz) from the vertex
+  /// (x, y, z) onto every plane. out must hold 2 * planes.size() * n values:
+  /// out[(2k) n + i] and out[(2k+1) n + i] are u and v of neutrino i on
+  /// plane k.
+  inline void Project(const std::vector<Plane>& planes, double x, double y, double z,
+                      const double* px, const double* py, const double* pz,
+                      std::size_t n, double* out)
+  {
+    for (std::size_t k = 0; k < planes.size(); ++k) {
+      const Plane& plane = planes[k];
+      const double dx = plane.cx - x, dy = plane.cy - y, dz = plane.cz - z;
+      const double distance = plane.nx * dx + plane.ny * dy + plane.nz * dz;
+      double* u = out + 2 * k * n;
+      double* v = u + n;
+      for (std::size_t i = 0; i < n; ++i) {
+        const double approach = plane.nx * px[i] + plane.ny * py[i] + plane.nz * pz[i];
+        const bool forward = approach > 0. && distance * approach > 0.;
+        const double t = forward ? distance / approach : 0.;
+        const double rx = t * px[i] - dx, ry = t * py[i] - dy, rz = t * pz[i] - dz;
+        u[i] = forward ? plane.ux * rx + plane.uy * ry + plane.uz * rz : kNoIntersection;
+        v[i] = forward ? plane.vx * rx + plane.vy * ry + plane.vz * rz : kNoIntersection;
+      }
+    }
+  }
+}  // namespace PlaneProjection
+
+}  // namespace mirage
+
+#endif
@@ -0,0 +1,71 @@
+/// \file common/include/SpscQueue.hh
+/// \brief Bounded lock-free single-producer single-consumer queue
+
+#ifndef MirageSpscQueue_h
+#define MirageSpscQueue_h 1
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace mirage
+{
+
+/// Ring buffer of \p capacity slots for one producer thread and one
+/// consumer thread. Push() and Pop() never block or allocate; they return
+/// false when the queue is full or empty. The head and tail indices are kept
+/// a cache line apart so that the two threads do not share one.
+
+template <class T>
+class SpscQueue
+{
+  public:
+    explicit SpscQueue(std::size_t capacity) : fSlots(capacity + 1) {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    /// Producer side
+    bool Push(const T& value)
+    {
+      const std::size_t tail = fTail.load(std::memory_order_relaxed);
+      const std::size_t next = Next(tail);
+      if (next == fHead.load(std::memory_order_acquire)) return false;
+      fSlots[tail] = value;
+      fTail.store(next, std::memory_order_release);
+      return true;
+    }
+
+    /// Consumer side
+    bool Pop(T& value)
+    {
+      const std::size_t head = fHead.load(std::memory_order_relaxed);
+      if (head == fTail.load(std::memory_order_acquire)) return false;
+      value = fSlots[head];
+      fHead.store(Next(head), std::memory_order_release);
+      return true;
+    }
+
+    /// Exact on the consumer side, a snapshot elsewhere
+    bool IsEmpty() const
+    {
+      return fHead.load(std::memory_order_acquire) == fTail.load(std::memory_order_acquire);
+    }
+
+    std::size_t GetCapacity() const { return fSlots.size() - 1; }
+
+  private:
+    std::size_t Next(std::size_t index) const
+    {
+      return index + 1 == fSlots.size() ? 0 : index + 1;
+    }
+
+    std::vector<T> fSlots;
+    std::atomic<std::size_t> fHead{0};
+    char fPadding[64];  // not alignas: heap allocation of over-aligned types needs C++17
+    std::atomic<std::size_t> fTail{0};
+};
+
+}  // namespace mirage
+
+#endif
@@ -0,0 +1,89 @@
+/// \file B1/include/AcceptanceFilter.hh
+/// \brief Definition of the B1::AcceptanceFilter class
+
+#ifndef B1AcceptanceFilter_h
+#define B1AcceptanceFilter_h 1
+
+#include "globals.hh"
+
+#include "DetectorConstruction.hh"
+
+#include "G4Version.hh"
+#if G4VERSION_NUMBER >= 1100
+  #include "G4AnalysisManager.hh"
+#else
+  #include "g4root.hh"
+#endif
+
+#include <vector>
+
+class G4GenericMessenger;
+class G4Track;
+
+namespace B1
+{
+
+class SteppingContext;
+
+/// Conservative test of whether a neutrino parent can still feed the
+/// near-detector window.
+///
+/// For a new pi+-, K+- or K0L it bounds, in each transverse projection, the
+/// landing point on the projection plane of any decay neutrino:
+///   x0 + (px/pz +- (alpha + kick/p)) * (zPlane - z0)
+/// where alpha = coneMultiplier / gamma is the neutrino opening angle kept
+/// (a fraction ~1/(1+k^2) of the neutrinos of a two-body decay, all soft, lie
+/// outside it) and kick is the largest transverse momentum the field regions
+/// still downstream of the track can add. Decaying further downstream only
+/// narrows the reachable interval, so testing at the creation point is safe.
+/// Tracks going backwards are never accepted; tracks too slow for the
+/// small-angle bound (alpha > maxCone) always are.
+///
+/// The window defaults to mirage::FluxWindow, the "ff" window of
+/// mirage_plot.C. Culled tracks can be written to the "culled" ntuple so the
+/// flux bias of the cut can be checked. Controlled by /mirage/acceptance/.
+
+class AcceptanceFilter
+{
+  public:
+    AcceptanceFilter();
+    ~AcceptanceFilter();
+
+    /// Caches the plane and the field regions; call after SteppingContext::Build()
+    void Build(const SteppingContext& context);
+    /// Books the "culled" ntuple if enabled; call after the main ntuple
+    void BookNtuple(G4AnalysisManager* analysisManager);
+
+    G4bool IsEnabled() const { return fEnabled; }
+    G4bool HasNtuple() const { return fNtupleId >= 0; }
+    /// True for the species the filter applies to
+    static G4bool IsCandidate(G4int pdg)
+    {
+      return pdg == 211 || pdg == -211 || pdg == 321 || pdg == -321 || pdg == 130;
+    }
+    G4bool CanReachWindow(const G4Track* track) const;
+    void RecordCulled(const G4Track* track) const;
+
+  private:
+    void DefineCommands();
+
+    G4GenericMessenger* fMessenger = nullptr;
+    G4AnalysisManager* fAnalysisManager = nullptr;
+    G4int fNtupleId = -1;
+
+    G4bool fEnabled = false;
+    G4bool fRecordCulled = true;
+    G4double fConeMultiplier = 10.;
+    G4double fMaxCone = 0.5;  // rad
+    G4double fHalfWidthX = 0.;
+    G4double fHalfWidthY = 0.;
+
+    G4double fPlaneZ = 0.;
+    std::vector<FieldRegionBound> fFieldRegions;
+};
+
+}  // namespace B1
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -32,6 +32,7 @@
 
 #include "G4VUserActionInitialization.hh"
 #include "G4String.hh"
+#include "globals.hh"
 
 namespace B1
 {
@@ -41,7 +42,7 @@ namespace B1
 class ActionInitialization : public G4VUserActionInitialization
 {
   public:
-    ActionInitialization(G4String fileName);
+    ActionInitialization(G4String fileName, G4long seed);
     ~ActionInitialization() override = default;
 
     void BuildForMaster() const override;
@@ -49,6 +50,7 @@ class ActionInitialization : public G4VUserActionInitialization
 
   private:
     G4String fFileName;
+    G4long fSeed;
 
 };
 
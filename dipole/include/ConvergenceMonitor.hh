@@ -0,0 +1,110 @@
+/// \file B1/include/ConvergenceMonitor.hh
+/// \brief Definition of the B1::ConvergenceMonitor class
+
+#ifndef B1ConvergenceMonitor_h
+#define B1ConvergenceMonitor_h 1
+
+#include "globals.hh"
+
+#include <atomic>
+#include <vector>
+
+class G4GenericMessenger;
+
+namespace B1
+{
+
+/// Ends a run once the flux in a set of energy bins has converged, instead
+/// of after a fixed number of POT.
+///
+/// Bins are added with /mirage/convergence/bins <flavour> <selection>
+/// <bins> <Emin> <Emax> (GeV), with the flavours and selections of
+/// FluxHistograms, e.g. "numu ff 20 0 10" for the numu spectrum in the
+/// near detector window. The rows of one event share its hadron cascade
+/// (and the multiplexed decays share their parent), so the unit of the
+/// statistics is the event: w is the weight an event puts into a bin.
+/// Every thread adds its sums to the run totals every
+/// /mirage/convergence/checkEvery events; when the relative uncertainty
+/// sqrt(sum w^2) / sum w of every bin is below
+/// /mirage/convergence/precision, or the run has /mirage/convergence/maxPOT
+/// events, every thread ends its run after its current event
+/// (G4RunManager::AbortRun()). The POT of the run ntuple are then the
+/// events actually simulated. Start such runs with a /run/beamOn large
+/// enough never to be reached.
+///
+/// One per thread, owned by RunAction; filled from SteppingAction. The run
+/// totals are shared by the threads.
+
+class ConvergenceMonitor
+{
+  public:
+    ConvergenceMonitor();
+    ~ConvergenceMonitor();
+
+    G4bool IsEnabled() const { return (fPrecision > 0. && !fRanges.empty()) || fMaxPOT > 0; }
+
+    /// Resolves the selections against the plane and location columns of a
+    /// row (OutputNtuples::GetExtraColumnNames()); the master, or the only
+    /// thread, also resets the run totals
+    void BeginOfRun(const std::vector<G4String>& columnNames, G4bool master);
+    /// Adds one neutrino row (GeV, columns as in OutputBuffer::AddNeutrino())
+    void Fill(G4int pdg, G4double E, G4double pz, G4double weight, const G4double* columns);
+    /// Adds the bins of the event to the sums of the thread; true when the
+    /// run is to end after this event
+    G4bool EndOfEvent();
+    /// Adds the rows of the thread not yet in the run totals
+    void EndOfRun();
+    /// Why and where the run ended (master, or the only thread)
+    void PrintSummary(G4int nofEvents) const;
+
+  private:
+    enum Selection { kAll, kForward, kWindow };
+
+    struct Range
+    {
+      G4int pdg;  // 0 for all flavours
+      Selection selection;
+      G4int nofBins;
+      G4double min, max;  // GeV
+      G4String label;
+    };
+
+    // run totals, shared by the threads
+    struct Totals
+    {
+      std::vector<G4double> sumW, sumW2;
+      G4double worst = 0.;
+      G4int worstBin = -1;
+      G4bool converged = false;
+    };
+
+    void AddBins(const G4String& args);
+    void ClearBins();
+    void Synchronise();
+    void DefineCommands();
+    static Totals& GetTotals();
+    static std::atomic<G4long>& GetNofEvents();
+    static std::atomic<bool>& GetStop();
+
+    G4GenericMessenger* fMessenger = nullptr;
+    std::vector<Range> fRanges;
+    G4double fPrecision = 0.;
+    G4int fMaxPOT = 0;
+    G4int fCheckEvery = 1000;
+
+    // sums of this thread since the last Synchronise(), all bins in a row
+    std::vector<G4double> fSumW, fSumW2;
+    // weight of the current event per bin, and the bins it filled
+    std::vector<G4double> fEventW;
+    std::vector<G4int> fEventBins;
+    G4int fNofBins = 0;
+    G4int fNofEvents = 0;
+    G4int fWindowX = -1;  // columns of the at574m plane
+    G4int fWindowY = -1;
+};
+
+}  // namespace B1
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -30,17 +30,25 @@
 #ifndef B1EventAction_h
 #define B1EventAction_h 1
 
+#include "G4ThreeVector.hh"
 #include "G4UserEventAction.hh"
 #include "globals.hh"
 
+#include <cstddef>
+
 class G4Event;
 
 namespace B1
 {
 
 class RunAction;
+struct OutputBuffer;
 
 /// Event action class
+///
+/// Counts the decays of the event, which link the neutrino rows to their
+/// parent, and hands SteppingAction the output buffer of the worker. At the
+/// end of the event RunAction may roll the output over to the next file.
 
 class EventAction : public G4UserEventAction
 {
@@ -51,8 +59,15 @@ class EventAction : public G4UserEventAction
     void BeginOfEventAction(const G4Event* event) override;
     void EndOfEventAction(const G4Event* event) override;
 
+    /// Adds the parent of a decay with \p nofNeutrinos neutrinos to the
+    /// output and returns the buffer to add the neutrinos to
+    OutputBuffer* BeginDecay(G4int parentPDG, const G4ThreeVector& parentMom, G4double parentE,
+                             const G4ThreeVector& decayPos, std::size_t nofNeutrinos);
+
   private:
     RunAction* fRunAction = nullptr;
+    G4int fEventID = 0;
+    G4int fNofDecays = 0;
 };
 
 }  // namespace B1
@@ -0,0 +1,72 @@
+/// \file B1/include/EventSeeds.hh
+/// \brief Definition of the B1::EventSeeds class
+
+#ifndef B1EventSeeds_h
+#define B1EventSeeds_h 1
+
+#include "globals.hh"
+
+class G4GenericMessenger;
+
+namespace B1
+{
+
+/// Per-event random streams. With /mirage/random/perEvent true the engine
+/// of the thread is reseeded from (seed of the command line, event number)
+/// before the primaries of every event are generated, instead of going on
+/// with the stream of the thread (sequential) or taking the seeds the
+/// master drew for the event (multithreaded). An event then draws the same
+/// numbers whatever the thread count, run manager and event modulo, so the
+/// output is the same up to the order of the rows, and any event can be
+/// rerun alone:
+///
+///   /mirage/random/perEvent true
+///   /mirage/random/firstEvent 81234
+///   /run/beamOn 1
+///
+/// Event numbers count the events of the earlier runs of the job, from
+/// /mirage/random/firstEvent. The cost of a reseed depends on the engine
+/// (--engine=): a full state for MTwist, a skip to a unique stream for
+/// MixMax, nothing for the counter-based Philox.
+/// /mirage/random/benchmark <nofEvents> prints it for each of them.
+///
+/// One per thread, owned by RunAction; used by PrimaryGeneratorAction.
+
+class EventSeeds
+{
+  public:
+    EventSeeds();
+    ~EventSeeds();
+
+    /// Seed of the command line, the same on every thread
+    void SetRunSeed(G4long seed) { fRunSeed = seed; }
+    G4long GetRunSeed() const { return fRunSeed; }
+    G4bool IsEnabled() const { return fPerEvent; }
+
+    /// Numbers the events of a run of \p nofEvents after the earlier runs
+    void BeginOfRun(G4int nofEvents);
+    /// Reseeds the engine of the calling thread for event \p eventID of the run
+    void Reseed(G4int eventID) const;
+    /// Times the reseeding and the numbers of each engine, if enabled
+    void RunBenchmark() const;
+
+    /// Seeds of event \p event of the job (zero-terminated)
+    static void GetSeeds(G4long runSeed, G4long event, long seeds[3]);
+
+  private:
+    void DefineCommands();
+
+    G4GenericMessenger* fMessenger = nullptr;
+    G4bool fPerEvent = false;
+    G4int fFirstEvent = 0;
+    G4int fBenchmarkEvents = 0;
+    G4long fRunSeed = 0;
+    G4long fNofJobEvents = 0;   // events of the earlier runs
+    G4long fRunFirstEvent = 0;  // event number of event 0 of the run
+};
+
+}  // namespace B1
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
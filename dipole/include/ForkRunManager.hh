@@ -0,0 +1,77 @@
+/// \file B1/include/ForkRunManager.hh
+/// \brief Definition of the B1::ForkRunManager class
+
+#ifndef B1ForkRunManager_h
+#define B1ForkRunManager_h 1
+
+#include "G4RunManager.hh"
+
+#include <sys/types.h>
+
+#include <vector>
+
+namespace B1
+{
+
+/// Sequential run manager that runs a job as N processes (--fork=N, or
+/// --fork=max for one process per core), for the nodes where the
+/// multithreaded run managers cannot be used. The first
+/// /run/beamOn builds the geometry and the physics tables once, in the
+/// parent (a /run/beamOn 0), then forks N processes, which share these
+/// pages copy-on-write instead of building them N times:
+///
+///   process i   events [i n / N, (i + 1) n / N) of every run, with their
+///               event IDs in the job; its own random stream; the rest of
+///               the macro
+///   parent      waits for the processes, merges their manifests into the
+///               manifest of the job (RunManifest), prints the throughput
+///               and the memory of the processes, and exits with 1 if any
+///               of them failed
+///
+/// Every process writes <name>_p<i>.root (RunManifest::GetProcessName()).
+/// With /mirage/random/perEvent true the events are those of a single
+/// process; otherwise process i draws from the stream of event -1 - i
+/// (EventSeeds::GetSeeds()). /mirage/convergence/ stops each process on
+/// its own share. With --pin process i is pinned as worker thread i would
+/// be (mirage::NumaLayout). The peak PSS counts the shared pages once;
+/// scripts/bench_fork.sh compares it with N independent processes.
+
+class ForkRunManager : public G4RunManager
+{
+  public:
+    ForkRunManager(G4int nofProcesses, const G4String& outputName, G4long seed);
+    ~ForkRunManager() override = default;
+
+    void BeamOn(G4int nofEvents, const char* macroFile = nullptr,
+                G4int nofSelect = -1) override;
+    /// The share of the calling process of the \p nofEvents of the run
+    void DoEventLoop(G4int nofEvents, const char* macroFile = nullptr,
+                     G4int nofSelect = -1) override;
+
+  private:
+    struct Process
+    {
+      pid_t pid;
+      G4int status = -1;
+      G4long peakRSS = 0;  // kB
+      G4long peakPSS = 0;  // kB
+      G4bool running = true;
+    };
+
+    void RunProcess(G4int process, G4int nofEvents, const char* macroFile, G4int nofSelect);
+    /// Waits for all \p processes, sampling their memory; \p peakPSS of
+    /// the parent and the processes together
+    void WaitForProcesses(std::vector<Process>& processes, G4long& peakPSS) const;
+    G4int FirstEvent(G4int process, G4int nofEvents) const;
+
+    G4int fNofProcesses;
+    G4String fOutputName;
+    G4long fSeed;
+    G4int fProcess = -1;  // in the parent
+};
+
+}  // namespace B1
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,97 @@
+/// \file B1/include/OutputBuffer.hh
+/// \brief Definition of the B1::OutputBuffer struct
+
+#ifndef B1OutputBuffer_h
+#define B1OutputBuffer_h 1
+
+#include "globals.hh"
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+namespace B1
+{
+
+/// Preallocated structure-of-arrays batch of output rows: the parents of
+/// the decays and their neutrino rows, with the plane and location columns
+/// of each row as a fixed-width block. Filled on the tracking thread
+/// (EventAction, SteppingAction) and written by OutputNtuples on the
+/// OutputWriter thread. Parents are only added together with their
+/// neutrinos, so a buffer never holds more parents than rows.
+
+struct OutputBuffer
+{
+  OutputBuffer(std::size_t rows, std::size_t extraColumns) { Resize(rows, extraColumns); }
+
+  /// Drops the content
+  void Resize(std::size_t rows, std::size_t extraColumns)
+  {
+    capacity = rows;
+    nofExtraColumns = extraColumns;
+    nofRows = 0;
+    nofParents = 0;
+    parentEvent.resize(rows);
+    parentIndex.resize(rows);
+    parentPDG.resize(rows);
+    for (auto& values : parentValues) values.resize(rows);
+    rowParent.resize(rows);
+    rowPDG.resize(rows);
+    rowE.resize(rows);
+    rowPx.resize(rows);
+    rowPy.resize(rows);
+    rowPz.resize(rows);
+    rowWeight.resize(rows);
+    extra.resize(rows * extraColumns);
+  }
+
+  G4bool HasRoom(std::size_t rows) const { return nofRows + rows <= capacity; }
+  void Clear()
+  {
+    nofRows = 0;
+    nofParents = 0;
+  }
+
+  /// \p values are px, py, pz, E (GeV), x, y, z (m)
+  void AddParent(G4int event, G4int index, G4int pdg, const G4double values[7])
+  {
+    const std::size_t p = nofParents++;
+    parentEvent[p] = event;
+    parentIndex[p] = index;
+    parentPDG[p] = pdg;
+    for (std::size_t i = 0; i < 7; ++i) parentValues[i][p] = values[i];
+  }
+
+  /// Adds a neutrino (GeV) of the last parent; returns its plane and
+  /// location columns to fill
+  G4double* AddNeutrino(G4int pdg, G4double E, G4double px, G4double py, G4double pz,
+                        G4double weight)
+  {
+    const std::size_t r = nofRows++;
+    rowParent[r] = static_cast<G4int>(nofParents - 1);
+    rowPDG[r] = pdg;
+    rowE[r] = E;
+    rowPx[r] = px;
+    rowPy[r] = py;
+    rowPz[r] = pz;
+    rowWeight[r] = weight;
+    return extra.data() + r * nofExtraColumns;
+  }
+
+  std::size_t capacity = 0;
+  std::size_t nofExtraColumns = 0;
+  std::size_t nofRows = 0;
+  std::size_t nofParents = 0;
+
+  std::vector<G4int> parentEvent, parentIndex, parentPDG;
+  std::array<std::vector<G4double>, 7> parentValues;
+  std::vector<G4int> rowParent, rowPDG;
+  std::vector<G4double> rowE, rowPx, rowPy, rowPz, rowWeight;
+  std::vector<G4double> extra;
+};
+
+}  // namespace B1
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,74 @@
+/// \file B1/include/OutputParts.hh
+/// \brief Definition of the B1::OutputParts class
+
+#ifndef B1OutputParts_h
+#define B1OutputParts_h 1
+
+#include "globals.hh"
+
+class G4GenericMessenger;
+
+namespace B1
+{
+
+/// Parts of the output file of a thread: the events, event range and
+/// neutrino rows each covers.
+///
+/// With /mirage/output/roll/maxRows or maxSize set, the output of a thread
+/// rolls over to the next file <name>_partNNN once the current one holds
+/// that many neutrino rows or megabytes. RunAction checks at the end of each
+/// event, so that a part holds whole events: it writes the part's run row
+/// (with its POT and event range), closes the file, which can then be
+/// transferred, and opens the next part. Every part is listed in the run
+/// manifest (RunManifest). In multithreaded mode the parts are per worker,
+/// <name>_partNNN_t<N>.root, and need /mirage/output/merge false.
+/// Without rolling there is one part, the file of the thread.
+
+class OutputParts
+{
+  public:
+    OutputParts();
+    ~OutputParts();
+
+    G4bool IsRollingEnabled() const { return fMaxRows > 0 || fMaxMegabytes > 0.; }
+    G4bool IsRolling() const { return fRolling; }
+
+    /// Starts the run; returns the file name to open
+    G4String Begin(const G4String& outputName, G4bool rolling);
+    /// Adds an event to the current part, \p nofRows counting the rows of
+    /// the run so far; true when the part is full
+    G4bool EndOfEvent(G4int eventID, G4long nofRows);
+    /// Starts the next part after \p nofRows rows of the run; returns the
+    /// file name to open
+    G4String Next(G4long nofRows);
+
+    /// File name of the current part, as given to the analysis manager
+    const G4String& GetName() const { return fName; }
+    G4int GetNofEvents() const { return fNofEvents; }
+    G4int GetFirstEvent() const { return fFirstEvent; }
+    G4int GetLastEvent() const { return fLastEvent; }
+    G4long GetNofRows(G4long nofRows) const { return nofRows - fFirstRow; }
+
+  private:
+    void DefineCommands();
+
+    G4GenericMessenger* fMessenger = nullptr;
+    G4int fMaxRows = 0;
+    G4double fMaxMegabytes = 0.;
+
+    G4String fOutputName;
+    G4bool fRolling = false;
+    G4int fIndex = 0;
+    G4String fName;
+    G4String fFileName;  // on disk, with the thread suffix
+    G4int fNofEvents = 0;
+    G4int fFirstEvent = -1;
+    G4int fLastEvent = -1;
+    G4long fFirstRow = 0;
+};
+
+}  // namespace B1
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
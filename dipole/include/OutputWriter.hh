@@ -0,0 +1,110 @@
+/// \file B1/include/OutputWriter.hh
+/// \brief Definition of the B1::OutputWriter class
+
+#ifndef B1OutputWriter_h
+#define B1OutputWriter_h 1
+
+#include "OutputBuffer.hh"
+#include "SpscQueue.hh"
+
+#include "globals.hh"
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <vector>
+
+class G4GenericMessenger;
+
+namespace B1
+{
+
+class FluxStore;
+class OutputNtuples;
+
+/// Hands the neutrino rows of a worker to the output file in batches.
+///
+/// EventAction and SteppingAction append the rows to an OutputBuffer
+/// (Reserve()). A full buffer goes through a bounded lock-free queue to a
+/// writer thread of the worker, which fills the ntuples (OutputNtuples::
+/// Write(), including the basket compression) and the flux file (FluxStore)
+/// and returns the buffer through
+/// a second queue. Tracking never waits for the writer: when no buffer is
+/// free a new one is allocated, and when the queue is full the buffer waits
+/// in a local backlog until the next submission. Stop() drains the queue at
+/// the end of the run, before the file is written, and Flush() before an
+/// output file is rolled over (OutputParts).
+///
+/// The writer thread is the only user of the worker's ntuples during the
+/// run. When the "culled" ntuple of AcceptanceFilter is booked, it shares
+/// the file with the tracking thread and the buffers are written inline.
+/// With --pin the buffers are allocated by the pinned worker, on its NUMA
+/// node, and the writer thread runs on the cores of that node.
+/// Controlled by /mirage/output/writer/. Owned by RunAction.
+
+class OutputWriter
+{
+  public:
+    OutputWriter();
+    ~OutputWriter();
+
+    /// Sizes the buffers and starts the writer thread (after booking);
+    /// \p inlineOnly writes on the calling thread. The rows also go to
+    /// \p fluxStore while it is open.
+    void Start(OutputNtuples* outputNtuples, FluxStore* fluxStore, G4bool inlineOnly);
+    /// Writes the remaining rows and stops the writer thread (before Write())
+    void Stop();
+    /// Writes the rows so far and waits for the writer thread to be idle
+    void Flush();
+
+    /// Buffer with room for \p nofRows more rows; submits the current one
+    /// when it is full
+    OutputBuffer* Reserve(std::size_t nofRows);
+
+    /// Rows of the run so far, written or not
+    G4long GetNofRows() const { return fNofRows + (fCurrent ? G4long(fCurrent->nofRows) : 0); }
+
+    /// Writer activity of the run, relative to \p runTime (s)
+    void PrintSummary(G4double runTime) const;
+
+  private:
+    void Submit();
+    void Write(const OutputBuffer& buffer);
+    void WriteBuffers();
+    OutputBuffer* TakeFreeBuffer();
+    void DefineCommands();
+
+    G4GenericMessenger* fMessenger = nullptr;
+    G4bool fAsync = true;
+    G4int fBufferRows = 4096;
+    G4int fQueueDepth = 8;
+
+    OutputNtuples* fOutputNtuples = nullptr;
+    FluxStore* fFluxStore = nullptr;
+    G4bool fRunning = false;
+    G4bool fThreaded = false;
+    std::size_t fNofExtraColumns = 0;
+
+    std::vector<std::unique_ptr<OutputBuffer>> fPool;
+    OutputBuffer* fCurrent = nullptr;
+    std::deque<OutputBuffer*> fBacklog;
+    std::unique_ptr<mirage::SpscQueue<OutputBuffer*>> fFull;
+    std::unique_ptr<mirage::SpscQueue<OutputBuffer*>> fFree;
+    std::thread fThread;
+    std::atomic<bool> fStopping{false};
+    std::atomic<G4long> fNofWritten{0};  // buffers
+
+    // statistics of the run
+    G4long fNofBuffers = 0;
+    G4long fNofRows = 0;
+    std::size_t fBacklogPeak = 0;
+    G4double fWriteTime = 0.;  // s, written by the writer thread until joined
+    G4double fDrainTime = 0.;  // s
+};
+
+}  // namespace B1
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
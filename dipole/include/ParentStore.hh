@@ -0,0 +1,61 @@
+/// \file B1/include/ParentStore.hh
+/// \brief Definition of the B1::ParentStore class
+
+#ifndef B1ParentStore_h
+#define B1ParentStore_h 1
+
+#include "ParentRecord.hh"
+
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+
+#include <fstream>
+#include <vector>
+
+class G4GenericMessenger;
+
+namespace B1
+{
+
+/// Binary dump of the pi+-, K+-, K0L and mu+- decays (mirage::ParentRecord) for
+/// re-decaying them offline with tools/redecay, e.g. to move the projection
+/// plane or the window without re-running Geant4.
+///
+/// One file per worker, <output>.parents[_t<thread>].bin next to the ROOT
+/// output, rewritten at each run. Owned by RunAction, which opens and closes
+/// it; SteppingAction records the decays. Enabled with
+/// /mirage/parents/dump (after /run/initialize).
+
+class ParentStore
+{
+  public:
+    ParentStore();
+    ~ParentStore();
+
+    G4bool IsEnabled() const { return fEnabled; }
+    G4bool IsOpen() const { return fFile.is_open(); }
+
+    /// Opens the file of this thread; \p worldHalfZ locates the upstream face
+    void Open(const G4String& outputName, G4double worldHalfZ);
+    void Record(G4int pdg, const G4ThreeVector& momentum, G4double energy,
+                const G4ThreeVector& position, G4double weight);
+    /// Flushes the records and writes the header
+    void Close(G4int nofEvents);
+
+  private:
+    void Flush();
+    void DefineCommands();
+
+    G4GenericMessenger* fMessenger = nullptr;
+    G4bool fEnabled = false;
+
+    std::ofstream fFile;
+    mirage::ParentFileHeader fHeader{};
+    std::vector<mirage::ParentRecord> fBuffer;
+};
+
+}  // namespace B1
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,87 @@
+/// \file B1/include/RunManifest.hh
+/// \brief Definition of the B1::RunManifest class
+
+#ifndef B1RunManifest_h
+#define B1RunManifest_h 1
+
+#include "globals.hh"
+
+#include <vector>
+
+namespace B1
+{
+
+/// Manifest of a run written in parts: without ntuple merging
+/// (/mirage/output/merge false) every worker writes its rows to its own
+/// file <name>_t<N>.root, and with rolling (OutputParts) every thread
+/// writes a sequence of files <name>_partNNN. The master writes
+/// <name>.manifest, which lists them as one dataset:
+///
+///   # mirage run manifest
+///   schema flat
+///   seed 1234
+///   pot 100000
+///   runs result.root
+///   part result_t0.root 0 50123 81234 0 99999
+///
+/// with one "part" line per file (file, thread, POT, neutrino rows, first
+/// and last event ID). The "runs" file is the one of the master in
+/// multithreaded mode, with the run ntuple and the histograms; every part
+/// also has the run row of its own events. File names are relative to the
+/// manifest. analyzer/MirageView.hh chains the parts;
+/// scripts/merge_manifest.sh merges them into one file.
+///
+/// The threads add their parts as they close them, the master writes the
+/// manifest after all of them (RunAction::EndOfRunAction()).
+///
+/// With --fork (ForkRunManager) every process writes <name>_p<N>.root and
+/// its parts, and <name>_p<N>.manifest; the parent merges these into
+/// <name>.manifest, with the process in the thread column.
+
+class RunManifest
+{
+  public:
+    /// File written by the calling thread for \p outputName
+    static G4String GetPartName(const G4String& outputName);
+
+    /// Forked process \p process of the job (ForkRunManager), -1 for none
+    static void SetProcess(G4int process) { GetProcessIndex() = process; }
+    static G4int GetProcess() { return GetProcessIndex(); }
+    /// Output name of the calling process for the output name of the job
+    static G4String GetProcessName(const G4String& outputName);
+
+    /// Adds a closed part of the calling thread, \p partName as given to
+    /// the analysis manager
+    static void AddPart(const G4String& partName, G4int nofPOT, G4long nofRows,
+                        G4int firstEvent, G4int lastEvent);
+
+    /// Writes the manifest of the parts added since the last call and
+    /// clears them, with the "runs" line if \p masterFile; returns the file
+    /// names of the parts
+    static std::vector<G4String> Write(const G4String& outputName, const G4String& schema,
+                                       G4long seed, G4int nofPOT, G4bool masterFile);
+
+    /// Merges the manifests of the \p nofProcesses forked processes into
+    /// the manifest of the job and removes them; returns the POT of the
+    /// processes that wrote one
+    static G4long MergeProcesses(const G4String& outputName, G4int nofProcesses, G4long seed);
+
+  private:
+    struct Part
+    {
+      G4String fileName;
+      G4int thread;
+      G4int nofPOT;
+      G4long nofRows;
+      G4int firstEvent, lastEvent;
+    };
+
+    static std::vector<Part>& GetParts();
+    static G4int& GetProcessIndex();
+};
+
+}  // namespace B1
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,34 @@
+/// \file B1/include/SpecialCutsPhysics.hh
+/// \brief Definition of the B1::SpecialCutsPhysics class
+
+#ifndef B1SpecialCutsPhysics_h
+#define B1SpecialCutsPhysics_h 1
+
+#include "G4VPhysicsConstructor.hh"
+#include "globals.hh"
+
+namespace B1
+{
+
+/// Physics constructor attaching G4UserSpecialCuts to every particle.
+///
+/// Makes the G4UserLimits of the regions effective: the envelope kill
+/// volume and the per-region tracking floors (minimum kinetic energy).
+/// Unlike G4StepLimiterPhysics it does not add G4StepLimiter, so the maximum
+/// step set on the dipoles stays inactive as before.
+
+class SpecialCutsPhysics : public G4VPhysicsConstructor
+{
+  public:
+    SpecialCutsPhysics(const G4String& name = "SpecialCuts");
+    ~SpecialCutsPhysics() override = default;
+
+    void ConstructParticle() override {}
+    void ConstructProcess() override;
+};
+
+}  // namespace B1
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
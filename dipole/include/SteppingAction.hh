@@ -30,30 +30,68 @@
 #ifndef B1SteppingAction_h
 #define B1SteppingAction_h 1
 
+#include "DecayMultiplexer.hh"
+
+#include "G4ThreeVector.hh"
 #include "G4UserSteppingAction.hh"
 
+#include <vector>
+
 class G4LogicalVolume;
 class G4Step;
 
 namespace B1
 {
 
+class ConvergenceMonitor;
 class EventAction;
+class FluxHistograms;
+class LocationWeights;
+struct OutputBuffer;
+class ParentStore;
+class ProjectionPlanes;
+class SteppingContext;
 
 /// Stepping action class
+///
+/// Adds one neutrino row per neutrino at each decay step, and the rows of
+/// the multiplexed decays (DecayMultiplexer), to the output buffer of the
+/// worker (EventAction::BeginDecay(), OutputWriter). The pi+-, K+- and
+/// K0L decays also go to the parent-decay store when it is open. The
+/// neutrinos of a decay are collected first and projected onto the
+/// configured planes in one batch; each row also gets the weights of the
+/// configured detector locations, and goes to the flux histograms and the
+/// convergence monitor.
 
 class SteppingAction : public G4UserSteppingAction
 {
   public:
-    SteppingAction(EventAction* eventAction);
+    SteppingAction(EventAction* eventAction, const SteppingContext* context,
+                   ParentStore* parentStore, const LocationWeights* locationWeights,
+                   ProjectionPlanes* projectionPlanes, const FluxHistograms* fluxHistograms,
+                   ConvergenceMonitor* convergenceMonitor);
     ~SteppingAction() override = default;
 
     // method from the base class
     void UserSteppingAction(const G4Step*) override;
 
   private:
+    void FillRow(OutputBuffer* buffer, const G4ThreeVector& parentMom, G4double parentE,
+                 const G4ThreeVector& decayPos, size_t i) const;
+
     EventAction* fEventAction = nullptr;
     G4LogicalVolume* fScoringVolume = nullptr;
+    const SteppingContext* fContext = nullptr;
+    ParentStore* fParentStore = nullptr;
+    const LocationWeights* fLocationWeights = nullptr;
+    ProjectionPlanes* fProjectionPlanes = nullptr;
+    const FluxHistograms* fFluxHistograms = nullptr;
+    ConvergenceMonitor* fConvergenceMonitor = nullptr;
+    DecayMultiplexer fMultiplexer;
+
+    // neutrinos of the current decay (GeV) and their weights
+    mirage::DecayKinematics::NeutrinoBatch fNeutrinos;
+    std::vector<G4double> fWeights;
 };
 
 }  // namespace B1
@@ -0,0 +1,51 @@
+/// \file B1/include/SteppingBenchmark.hh
+/// \brief Definition of the B1::SteppingBenchmark class
+
+#ifndef B1SteppingBenchmark_h
+#define B1SteppingBenchmark_h 1
+
+#include "globals.hh"
+
+#include <vector>
+
+class G4ParticleDefinition;
+class G4VProcess;
+
+namespace B1
+{
+
+class SteppingContext;
+
+/// Micro-benchmark of the per-step neutrino capture check.
+///
+/// Replays the real process instances and particle definitions of this
+/// thread through the original per-step lookup (analysis manager singleton,
+/// navigator walk to the world box, process name comparison, particle name
+/// copy + substring search) and through the SteppingContext fast path,
+/// and prints the cost of each per call.
+/// Enabled with /mirage/stepping/benchmark <nIterations>.
+
+class SteppingBenchmark
+{
+  public:
+    SteppingBenchmark(const SteppingContext* context);
+    ~SteppingBenchmark() = default;
+
+    void Run(G4long nofIterations);
+
+  private:
+    G4double TimeLegacyGate(G4long nofIterations, G4long& nofHits) const;
+    G4double TimeFastGate(G4long nofIterations, G4long& nofHits) const;
+    G4double TimeLegacyNeutrinoId(G4long nofIterations, G4long& nofHits) const;
+    G4double TimeFastNeutrinoId(G4long nofIterations, G4long& nofHits) const;
+
+    const SteppingContext* fContext = nullptr;
+    std::vector<const G4VProcess*> fProcesses;
+    std::vector<const G4ParticleDefinition*> fParticles;
+};
+
+}  // namespace B1
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
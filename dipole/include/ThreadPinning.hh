@@ -0,0 +1,45 @@
+/// \file B1/include/ThreadPinning.hh
+/// \brief Definition of the B1::ThreadPinning class
+
+#ifndef B1ThreadPinning_h
+#define B1ThreadPinning_h 1
+
+#include "NumaLayout.hh"
+
+#include "G4Threading.hh"
+#include "G4UserWorkerInitialization.hh"
+#include "G4ios.hh"
+
+namespace B1
+{
+
+/// Pins every worker thread to its core in the NUMA layout of --pin=
+/// (mirage::NumaLayout) when it starts, before it builds its user actions,
+/// so that its buffers and its writer thread (OutputWriter) are on the
+/// node of the core. Unlike /run/pinAffinity of Geant4, the layout knows
+/// the nodes and the cpuset of the job. Forked processes (--fork) are
+/// pinned by ForkRunManager.
+
+class ThreadPinning : public G4UserWorkerInitialization
+{
+  public:
+    void WorkerInitialize() const override
+    {
+      const G4int worker = G4Threading::G4GetThreadId();
+      const G4int cpu = mirage::NumaLayout::PinWorker(worker);
+      if (cpu < 0) {
+        G4cout << " Worker " << worker << " not pinned" << G4endl;
+        return;
+      }
+      const auto& layout = mirage::NumaLayout::Get();
+      G4cout << " Worker " << worker << " pinned to CPU " << cpu << " (node "
+             << layout.GetNodeId(layout.NodeOf(worker, mirage::NumaLayout::GetMode())) << ")"
+             << G4endl;
+    }
+};
+
+}  // namespace B1
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
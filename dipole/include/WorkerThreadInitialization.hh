@@ -0,0 +1,39 @@
+/// \file B1/include/WorkerThreadInitialization.hh
+/// \brief Definition of the B1::WorkerThreadInitialization class
+
+#ifndef B1WorkerThreadInitialization_h
+#define B1WorkerThreadInitialization_h 1
+
+#include "PhiloxEngine.hh"
+
+#include "Randomize.hh"
+
+namespace B1
+{
+
+/// Thread initialisation that gives every worker a new engine of the type
+/// of the master for the engines Geant4 cannot clone itself, i.e.
+/// mirage::PhiloxEngine (--engine=philox); the other engines are left to
+/// \p Base. \p Base is G4UserWorkerThreadInitialization for the MT run
+/// manager and G4UserTaskThreadInitialization for the tasking one.
+
+template <class Base>
+class WorkerThreadInitialization : public Base
+{
+  public:
+    void SetupRNGEngine(const CLHEP::HepRandomEngine* masterEngine) const override
+    {
+      if (dynamic_cast<const mirage::PhiloxEngine*>(masterEngine)) {
+        // seeded for every event by the run manager or by EventSeeds
+        G4Random::setTheEngine(new mirage::PhiloxEngine);
+        return;
+      }
+      Base::SetupRNGEngine(masterEngine);
+    }
+};
+
+}  // namespace B1
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -29,7 +29,13 @@
 
 #include "ActionInitialization.hh"
 #include "DetectorConstruction.hh"
-#include "FTFP_BERT.hh"
+#include "ForkRunManager.hh"
+#include "PhysicsListFactory.hh"
+#include "ThreadPinning.hh"
+#include "WorkerThreadInitialization.hh"
+
+#include "NumaLayout.hh"
+#include "PhiloxEngine.hh"
 
 #include "G4Version.hh"
 #if G4VERSION_NUMBER >= 1100
@@ -41,21 +47,159 @@
 #include "G4RunManager.hh"
   #endif
 #endif
+#ifdef G4MULTITHREADED
+#include "G4UserWorkerThreadInitialization.hh"
+  #if G4VERSION_NUMBER >= 1100
+#include "G4TaskRunManager.hh"
+#include "G4UserTaskThreadInitialization.hh"
+  #endif
+#endif
 
 #include "G4SystemOfUnits.hh"
 #include "G4SteppingVerbose.hh"
+#include "G4Threading.hh"
 #include "G4UIExecutive.hh"
 #include "G4UImanager.hh"
 #include "G4VisExecutive.hh"
 
+#include <stdexcept>
+#include <string>
+#include <vector>
+
 // #include "Randomize.hh"
 
 using namespace B1;
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
+namespace
+{
+  // --run-manager=: default (G4RunManagerFactory, G4FORCE_RUN_MANAGER_TYPE),
+  // serial, mt (events handed out in bunches of the event modulo) or tasking
+  // (events as tasks of a shared pool, idle workers take the next ones)
+  G4bool IsRunManagerType(const G4String& type)
+  {
+    return type == "default" || type == "serial" || type == "mt" || type == "tasking";
+  }
+
+  #if G4VERSION_NUMBER >= 1100
+  G4RunManagerType GetRunManagerType(const G4String& type)
+  {
+    if (type == "serial") return G4RunManagerType::Serial;
+    if (type == "mt") return G4RunManagerType::MT;
+    if (type == "tasking") return G4RunManagerType::Tasking;
+    return G4RunManagerType::Default;
+  }
+  #endif
+
+  // integer >= 0 given to \p option; anything else is fatal
+  G4int ParseCount(const G4String& option, const G4String& value, const G4String& expected)
+  {
+    std::size_t end = 0;
+    G4int count = -1;
+    try {
+      count = std::stoi(value, &end);
+    }
+    catch (const std::logic_error&) {
+      end = 0;
+    }
+    if (end == 0 || end != value.size() || count < 0) {
+      G4ExceptionDescription msg;
+      msg << "Invalid " << option << "=" << value << "; use " << expected << ".";
+      G4Exception("main()", "MIRAGE015", FatalErrorInArgument, msg);
+    }
+    return count;
+  }
+
+  // --threads=N or --threads=max (all cores of the node)
+  G4int ParseNofThreads(const G4String& option, const G4String& value)
+  {
+    if (value == "max") return G4Threading::G4GetNumberOfCores();
+    return ParseCount(option, value, "a number >= 0 or max");
+  }
+
+  // --fork=N or --fork=max (one process per core of the node); 0 and 1 run
+  // a single process
+  G4int ParseNofProcesses(const G4String& value)
+  {
+    if (value == "max") return G4Threading::G4GetNumberOfCores();
+    return ParseCount("--fork", value, "a number of processes >= 0 or max");
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
 int main(int argc, char** argv)
 {
+  // Options may appear anywhere on the command line, the rest are positional
+  // (ex: ./mirage --physics=flux --bias-decay --threads=8 run1.mac ...)
+  G4String physicsTier = "full";
+  G4bool biasDecay = false;
+  G4String runManagerType = "default";
+  G4int nofThreads = 0;     // Geant4 default (G4FORCENUMBEROFTHREADS, else 2)
+  G4int eventModulo = -1;   // Geant4 default
+  G4String engineName = "mtwist";
+  G4int nofProcesses = 0;   // no forked processes
+  G4String pinName = "none";
+  std::vector<char*> args;
+  for (G4int i = 0; i < argc; ++i) {
+    G4String arg = argv[i];
+    if (arg.compare(0, 10, "--physics=") == 0) {
+      physicsTier = arg.substr(10);
+    }
+    else if (arg == "--bias-decay") {
+      biasDecay = true;
+    }
+    else if (arg.compare(0, 10, "--threads=") == 0) {
+      nofThreads = ParseNofThreads("--threads", arg.substr(10));
+    }
+    else if (arg.compare(0, 14, "--run-manager=") == 0) {
+      runManagerType = arg.substr(14);
+    }
+    else if (arg.compare(0, 15, "--event-modulo=") == 0) {
+      eventModulo = ParseCount("--event-modulo", arg.substr(15), "a number of events >= 0");
+    }
+    else if (arg.compare(0, 9, "--engine=") == 0) {
+      engineName = arg.substr(9);
+    }
+    else if (arg.compare(0, 7, "--fork=") == 0) {
+      nofProcesses = ParseNofProcesses(arg.substr(7));
+    }
+    else if (arg.compare(0, 6, "--pin=") == 0) {
+      pinName = arg.substr(6);
+    }
+    else {
+      args.push_back(argv[i]);
+    }
+  }
+  argc = args.size();
+  argv = args.data();
+
+  if (!IsRunManagerType(runManagerType)) {
+    G4ExceptionDescription msg;
+    msg << "Unknown run manager type \"" << runManagerType << "\";"
+        << " use default, serial, mt or tasking.";
+    G4Exception("main()", "MIRAGE015", FatalErrorInArgument, msg);
+  }
+  if (engineName != "mtwist" && engineName != "mixmax" && engineName != "philox") {
+    G4ExceptionDescription msg;
+    msg << "Unknown random engine \"" << engineName << "\"; use mtwist, mixmax or philox.";
+    G4Exception("main()", "MIRAGE016", FatalErrorInArgument, msg);
+  }
+  // a change to the rounds would silently change every Philox stream
+  if (engineName == "philox" && !mirage::PhiloxEngine::PassesKnownAnswers()) {
+    G4ExceptionDescription msg;
+    msg << "The Philox engine does not reproduce the Random123 known-answer vectors.";
+    G4Exception("main()", "MIRAGE016", FatalException, msg);
+  }
+  mirage::NumaLayout::Mode pinMode = mirage::NumaLayout::kNone;
+  if (!mirage::NumaLayout::ParseMode(pinName, pinMode)) {
+    G4ExceptionDescription msg;
+    msg << "Unknown pinning \"" << pinName << "\"; use none, compact or scatter.";
+    G4Exception("main()", "MIRAGE018", FatalErrorInArgument, msg);
+  }
+  mirage::NumaLayout::SetMode(pinMode);
+
   // Detect interactive mode (if no arguments) and define UI session
   //
   G4UIExecutive* ui = nullptr;
@@ -63,6 +207,22 @@ int main(int argc, char** argv)
     ui = new G4UIExecutive(argc, argv);
   }
 
+  // --fork=N: one serial run manager, forked into N processes at the first
+  // /run/beamOn (ForkRunManager); batch mode only
+  if (nofProcesses > 1 && ui) {
+    G4ExceptionDescription msg;
+    msg << "--fork needs a macro (batch mode); running a single process.";
+    G4Exception("main()", "MIRAGE017", JustWarning, msg);
+    nofProcesses = 0;
+  }
+  if (nofProcesses > 1 && runManagerType != "default" && runManagerType != "serial") {
+    G4ExceptionDescription msg;
+    msg << "--fork runs a serial run manager in every process; --run-manager="
+        << runManagerType << " is ignored.";
+    G4Exception("main()", "MIRAGE017", JustWarning, msg);
+    runManagerType = "serial";
+  }
+
   // Default arguments
   G4double Bmag = 3.0 * tesla;
   G4long mySeed = 1234;
@@ -74,40 +234,85 @@ int main(int argc, char** argv)
     fileName = argv[4];
   }
 
-  // Optionally: choose a different Random engine...
-  G4Random::setTheEngine(new CLHEP::MTwistEngine);
+  // Random engine (--engine=): mtwist, mixmax or the counter-based philox,
+  // the cheapest to reseed for every event (/mirage/random/perEvent)
+  if (engineName == "mixmax") G4Random::setTheEngine(new CLHEP::MixMaxRng);
+  else if (engineName == "philox") G4Random::setTheEngine(new mirage::PhiloxEngine);
+  else G4Random::setTheEngine(new CLHEP::MTwistEngine);
   G4Random::setTheSeed(mySeed);
 
   // use G4SteppingVerboseWithUnits
   //G4int precision = 4;
   //G4SteppingVerbose::UseBestUnit(precision);
 
-  // Construct the default run manager
+  // Construct the run manager (--fork, --run-manager, --threads)
   //
+  G4RunManager* runManager = nullptr;
+  if (nofProcesses > 1) runManager = new ForkRunManager(nofProcesses, fileName, mySeed);
   #if G4VERSION_NUMBER >= 1100
-  auto runManager = G4RunManagerFactory::CreateRunManager(G4RunManagerType::Default);
+  if (!runManager) {
+    runManager = G4RunManagerFactory::CreateRunManager(GetRunManagerType(runManagerType));
+  }
   #else
     #ifdef G4MULTITHREADED
-  auto* runManager = new G4MTRunManager;
-    #else
-  auto* runManager = new G4RunManager;
+  if (runManagerType == "tasking") {
+    G4ExceptionDescription msg;
+    msg << "The tasking run manager needs Geant4 11; using the MT run manager.";
+    G4Exception("main()", "MIRAGE015", JustWarning, msg);
+  }
+  if (!runManager && runManagerType != "serial") runManager = new G4MTRunManager;
+    #endif
+  if (!runManager) runManager = new G4RunManager;
+  #endif
+  // ignored by the serial run manager
+  if (nofThreads > 0) runManager->SetNumberOfThreads(nofThreads);
+
+  #ifdef G4MULTITHREADED
+  // Geant4 cannot clone the Philox engine for the workers itself
+  if (engineName == "philox" && runManager->GetRunManagerType() != G4RunManager::sequentialRM) {
+    G4UserWorkerThreadInitialization* threadInitialization = nullptr;
+    #if G4VERSION_NUMBER >= 1100
+    if (dynamic_cast<G4TaskRunManager*>(runManager)) {
+      threadInitialization = new WorkerThreadInitialization<G4UserTaskThreadInitialization>;
+    }
     #endif
+    if (!threadInitialization) {
+      threadInitialization = new WorkerThreadInitialization<G4UserWorkerThreadInitialization>;
+    }
+    runManager->SetUserInitialization(threadInitialization);
+  }
   #endif
 
+  // --pin=compact|scatter: the workers on their cores, node by node; the
+  // forked processes are pinned by ForkRunManager, a serial run here
+  if (pinMode != mirage::NumaLayout::kNone) {
+    const auto& layout = mirage::NumaLayout::Get();
+    G4cout << "Pinning the workers (" << pinName << ") to " << layout.GetNofCpus()
+           << " CPUs on " << layout.GetNofNodes() << " NUMA nodes" << G4endl;
+    if (runManager->GetRunManagerType() != G4RunManager::sequentialRM) {
+      runManager->SetUserInitialization(new ThreadPinning);
+    }
+    else if (nofProcesses <= 1) {
+      mirage::NumaLayout::PinWorker(0);
+    }
+  }
+
   // Set mandatory initialization classes
   //
   // Detector construction
   auto* detector = new DetectorConstruction();
   detector->SetDipoleBField(Bmag);
+  detector->SetDecayBiasing(biasDecay);
   runManager->SetUserInitialization(detector);
 
   // Physics list
-  auto physicsList = new FTFP_BERT;
+  // full (FTFP_BERT), flux or fast; see PhysicsListFactory
+  auto physicsList = PhysicsListFactory::Create(physicsTier, biasDecay);
   physicsList->SetVerboseLevel(1);
   runManager->SetUserInitialization(physicsList);
 
   // User action initialization
-  runManager->SetUserInitialization(new ActionInitialization(fileName));
+  runManager->SetUserInitialization(new ActionInitialization(fileName, mySeed));
 
   // Initialize visualization with the default graphics system
   G4VisManager* visManager = new G4VisExecutive;
@@ -121,6 +326,12 @@ int main(int argc, char** argv)
   // Get the pointer to the User Interface manager
   auto UImanager = G4UImanager::GetUIpointer();
 
+  // events per bunch handed to a worker (MT) or per task (tasking);
+  // a macro can still change it with /run/eventModulo
+  if (eventModulo >= 0) {
+    UImanager->ApplyCommand("/run/eventModulo " + std::to_string(eventModulo));
+  }
+
   // Process macro or start UI session
   //
   if (!ui) {
@@ -0,0 +1,34 @@
+#!/bin/bash
+
+# This script measures the throughput and the flux-shape deltas of the
+# physics tiers (--physics=flux|fast) against the full FTFP_BERT list.
+# Run it from the build directory:
+#   ./scripts/bench_physics.sh [B field [T]] [seed] [POT]
+# The flux comparison (analyzer/compare_tiers.C) needs root in the PATH.
+
+EXE=./mirage
+ARG=${1:-3.0}
+SEED=${2:-1234}
+export MIRAGE_POT=${3:-10000}
+MACRO_FILE=macros/bench_physics.mac
+TIERS="full flux fast"
+
+for TIER in $TIERS; do
+    echo "Running with --physics=$TIER ..."
+    $EXE --physics=$TIER $MACRO_FILE $ARG $SEED bench_physics_$TIER.root > bench_physics_$TIER.log 2>&1
+    if [ $? -ne 0 ]; then
+        echo "Error: $EXE failed, see bench_physics_$TIER.log"
+        exit 1
+    fi
+done
+
+# the global run summary is printed last
+MS_FULL=$(sed -n 's/.*(\([0-9.e+-]*\) ms\/POT).*/\1/p' bench_physics_full.log | tail -n 1)
+for TIER in $TIERS; do
+    MS=$(sed -n 's/.*(\([0-9.e+-]*\) ms\/POT).*/\1/p' bench_physics_$TIER.log | tail -n 1)
+    awk -v t="$TIER" -v a="$MS_FULL" -v b="$MS" 'BEGIN { printf "%-5s: %10.2f ms/POT   speed-up vs full: %.2fx\n", t, b, a / b }'
+done
+
+if command -v root > /dev/null; then
+    root -b -q -l "analyzer/compare_tiers.C(\"bench_physics_full.root\", \"bench_physics_flux.root,bench_physics_fast.root\")"
+fi
@@ -0,0 +1,52 @@
+#!/bin/bash
+
+# This script measures the cost of the random engines with per-event
+# seeding (/mirage/random/perEvent): the reseed and per-number cost of
+# MTwist, MixMax and Philox from the micro-benchmark of the master, and the
+# time per POT of a run with each of them. It then checks that the
+# per-event streams give the same neutrino rows at 1 and at N threads.
+# Run it from the build directory:
+#   ./scripts/bench_random.sh [B field [T]] [seed] [POT] [threads]
+
+EXE=./mirage
+ARG=${1:-3.0}
+SEED=${2:-1234}
+export MIRAGE_POT=${3:-10000}
+THREADS=${4:-4}
+MACRO_FILE=macros/bench_random.mac
+ENGINES="mtwist mixmax philox"
+
+run() {
+    local NAME=$1
+    shift
+    $EXE "$@" $MACRO_FILE $ARG $SEED $NAME.root > $NAME.log 2>&1
+    if [ $? -ne 0 ]; then
+        echo "Error: $EXE failed, see $NAME.log"
+        exit 1
+    fi
+}
+
+for ENGINE in $ENGINES; do
+    echo "Running with --engine=$ENGINE ..."
+    run bench_random_$ENGINE --engine=$ENGINE --threads=1
+done
+echo "Running with --engine=philox --threads=$THREADS ..."
+run bench_random_philox_mt --engine=philox --threads=$THREADS
+
+# the micro-benchmark is the same in every log
+sed -n '/Random engine benchmark/,/^-----*$/p' bench_random_mtwist.log
+
+# the global run summary is printed last
+for ENGINE in $ENGINES; do
+    MS=$(sed -n 's/.*(\([0-9.e+-]*\) ms\/POT).*/\1/p' bench_random_$ENGINE.log | tail -n 1)
+    printf "%-7s: %10s ms/POT\n" $ENGINE $MS
+done
+
+ROWS_1=$(sed -n 's/^ *\([0-9]*\) neutrino rows.*/\1/p' bench_random_philox.log | tail -n 1)
+ROWS_N=$(sed -n 's/^ *\([0-9]*\) neutrino rows.*/\1/p' bench_random_philox_mt.log | tail -n 1)
+if [ "$ROWS_1" = "$ROWS_N" ]; then
+    echo "philox, 1 and $THREADS threads: $ROWS_1 neutrino rows in both"
+else
+    echo "philox, 1 and $THREADS threads: $ROWS_1 and $ROWS_N neutrino rows differ"
+    exit 1
+fi
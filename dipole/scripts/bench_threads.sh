@@ -0,0 +1,47 @@
+#!/bin/bash
+
+# This script measures the multithreaded scaling: the same POT at 1, 2,
+# 4, ... threads up to the given maximum (default: all cores), with events/s,
+# parallel efficiency against one thread and the end-of-run time the master
+# spends merging and writing the output.
+# Run it from the build directory:
+#   ./scripts/bench_threads.sh [B field [T]] [seed] [POT] [max threads] [run manager]
+# The run manager is default, mt or tasking (--run-manager=).
+
+EXE=./mirage
+ARG=${1:-3.0}
+SEED=${2:-1234}
+export MIRAGE_POT=${3:-10000}
+MAX_THREADS=${4:-$(nproc)}
+RUN_MANAGER=${5:-default}
+MACRO_FILE=macros/bench_threads.mac
+
+THREADS=""
+for (( N = 1; N < MAX_THREADS; N *= 2 )); do
+    THREADS="$THREADS $N"
+done
+THREADS="$THREADS $MAX_THREADS"
+
+for N in $THREADS; do
+    NAME=bench_threads_$N
+    echo "Running with --threads=$N --run-manager=$RUN_MANAGER ..."
+    $EXE --threads=$N --run-manager=$RUN_MANAGER $MACRO_FILE $ARG $SEED $NAME.root > $NAME.log 2>&1
+    if [ $? -ne 0 ]; then
+        echo "Error: $EXE failed, see $NAME.log"
+        exit 1
+    fi
+done
+
+# the global run summary is printed last
+printf "%7s %10s %12s %11s %10s\n" threads time[s] events/s efficiency merge[s]
+RATE_1=""
+for N in $THREADS; do
+    NAME=bench_threads_$N
+    TIME=$(sed -n 's/.*real time: \([0-9.e+-]*\) s.*/\1/p' $NAME.log | tail -n 1)
+    MERGE=$(sed -n 's/.* \([0-9.e+-]*\) s to write and close.*/\1/p' $NAME.log | tail -n 1)
+    RATE=$(awk -v n="$MIRAGE_POT" -v t="$TIME" 'BEGIN { printf "%.3f", (t > 0 ? n / t : 0) }')
+    [ -z "$RATE_1" ] && RATE_1=$RATE
+    awk -v n="$N" -v t="$TIME" -v r="$RATE" -v r1="$RATE_1" -v m="${MERGE:-0}" 'BEGIN {
+        printf "%7d %10.2f %12.2f %10.1f%% %10.2f\n", n, t, r, (r1 > 0 ? 100. * r / (n * r1) : 0), m
+    }'
+done
@@ -7,6 +7,8 @@ NSUBRUNS=100
 # Set the base directory
 ABS_PATH="$(cd .. && pwd -P)"
 ANALYZER_SCRIPT_FILE="$ABS_PATH/analyzer/mirage_plot.C"
+ANALYZER_HEADER_FILE="$ABS_PATH/analyzer/FluxWindow.hh"
+ANALYZER_VIEW_FILE="$ABS_PATH/analyzer/MirageView.hh"
 echo $ABS_PATH
 echo $ANALYZER_SCRIPT_FILE
 USER=${USER}
@@ -18,5 +20,7 @@ jobsub_submit -N $NSUBRUNS \
     --group=dune \
     --resource-provides=usage_model=OPPORTUNISTIC,DEDICATED \
     -f dropbox://$ANALYZER_SCRIPT_FILE \
+    -f dropbox://$ANALYZER_HEADER_FILE \
+    -f dropbox://$ANALYZER_VIEW_FILE \
     file://$ABS_PATH/scripts/agent_ana.sh \
     $RUN_NUM $(basename $ANALYZER_SCRIPT_FILE) $USER
@@ -0,0 +1,167 @@
+/// \file B1/src/AcceptanceFilter.cc
+/// \brief Implementation of the B1::AcceptanceFilter class
+
+#include "AcceptanceFilter.hh"
+
+#include "SteppingContext.hh"
+
+#include "FluxWindow.hh"
+
+#include "G4GenericMessenger.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4PhysicalConstants.hh"
+#include "G4RunManager.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4Track.hh"
+
+#include <cmath>
+
+namespace B1
+{
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+AcceptanceFilter::AcceptanceFilter()
+  : fHalfWidthX(mirage::FluxWindow::kHalfWidthX * m),
+    fHalfWidthY(mirage::FluxWindow::kHalfWidthY * m)
+{
+  DefineCommands();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+AcceptanceFilter::~AcceptanceFilter()
+{
+  delete fMessenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void AcceptanceFilter::Build(const SteppingContext& context)
+{
+  fAnalysisManager = context.GetAnalysisManager();
+  fPlaneZ = context.GetProjectionPlaneZ();
+
+  // the detector construction is shared with the master: read only
+  auto detector = static_cast<const DetectorConstruction*>(
+    G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+  fFieldRegions = detector->GetFieldRegionBounds();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void AcceptanceFilter::BookNtuple(G4AnalysisManager* analysisManager)
+{
+  fNtupleId = -1;
+  if (!fEnabled || !fRecordCulled) return;
+
+  fNtupleId = analysisManager->CreateNtuple("culled", "Tracks culled by the acceptance filter");
+  analysisManager->CreateNtupleIColumn(fNtupleId, "pdg");
+  analysisManager->CreateNtupleDColumn(fNtupleId, "px");
+  analysisManager->CreateNtupleDColumn(fNtupleId, "py");
+  analysisManager->CreateNtupleDColumn(fNtupleId, "pz");
+  analysisManager->CreateNtupleDColumn(fNtupleId, "E");
+  analysisManager->CreateNtupleDColumn(fNtupleId, "vertexX");
+  analysisManager->CreateNtupleDColumn(fNtupleId, "vertexY");
+  analysisManager->CreateNtupleDColumn(fNtupleId, "vertexZ");
+  analysisManager->CreateNtupleDColumn(fNtupleId, "weight");
+  analysisManager->FinishNtuple(fNtupleId);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool AcceptanceFilter::CanReachWindow(const G4Track* track) const
+{
+  const G4ThreeVector& position = track->GetPosition();
+  const G4ThreeVector momentum = track->GetMomentum();
+
+  const G4double distance = fPlaneZ - position.z();
+  if (momentum.z() <= 0. || distance <= 0.) return false;
+
+  const G4ParticleDefinition* particle = track->GetDefinition();
+  const G4double gamma = track->GetTotalEnergy() / particle->GetPDGMass();
+  G4double spread = fConeMultiplier / gamma;
+  if (spread >= fMaxCone) return true;
+
+  const G4double charge = std::abs(particle->GetPDGCharge()) / eplus;
+  if (charge > 0.) {
+    G4double maxKick = 0.;
+    for (const auto& region : fFieldRegions) {
+      if (region.zMax > position.z()) maxKick += c_light * charge * region.maxBL;
+    }
+    spread += maxKick / momentum.mag();
+  }
+
+  // d(px/pz) = (1 + (px/pz)^2) d(theta_x), small angle changes
+  const G4double slopeX = momentum.x() / momentum.z();
+  const G4double slopeY = momentum.y() / momentum.z();
+  const G4double centreX = position.x() + slopeX * distance;
+  const G4double centreY = position.y() + slopeY * distance;
+  const G4double reachX = spread * (1. + slopeX * slopeX) * distance;
+  const G4double reachY = spread * (1. + slopeY * slopeY) * distance;
+
+  return std::abs(centreX) < fHalfWidthX + reachX && std::abs(centreY) < fHalfWidthY + reachY;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void AcceptanceFilter::RecordCulled(const G4Track* track) const
+{
+  if (fNtupleId < 0) return;
+
+  const G4ThreeVector momentum = track->GetMomentum();
+  const G4ThreeVector& position = track->GetPosition();
+
+  fAnalysisManager->FillNtupleIColumn(fNtupleId, 0, track->GetDefinition()->GetPDGEncoding());
+  fAnalysisManager->FillNtupleDColumn(fNtupleId, 1, momentum.x() / GeV);
+  fAnalysisManager->FillNtupleDColumn(fNtupleId, 2, momentum.y() / GeV);
+  fAnalysisManager->FillNtupleDColumn(fNtupleId, 3, momentum.z() / GeV);
+  fAnalysisManager->FillNtupleDColumn(fNtupleId, 4, track->GetTotalEnergy() / GeV);
+  fAnalysisManager->FillNtupleDColumn(fNtupleId, 5, position.x() / m);
+  fAnalysisManager->FillNtupleDColumn(fNtupleId, 6, position.y() / m);
+  fAnalysisManager->FillNtupleDColumn(fNtupleId, 7, position.z() / m);
+  fAnalysisManager->FillNtupleDColumn(fNtupleId, 8, track->GetWeight());
+  fAnalysisManager->AddNtupleRow(fNtupleId);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void AcceptanceFilter::DefineCommands()
+{
+  fMessenger = new G4GenericMessenger(this, "/mirage/acceptance/",
+                                      "Near-detector acceptance culling");
+
+  fMessenger->DeclareProperty("enable", fEnabled)
+    .SetGuidance("Kill pi+-, K+- and K0L whose decay neutrinos cannot reach the window.")
+    .SetParameterName("flag", true)
+    .SetDefaultValue("true");
+
+  fMessenger->DeclareProperty("recordCulled", fRecordCulled)
+    .SetGuidance("Write culled tracks to the \"culled\" ntuple (takes effect at the next run).")
+    .SetParameterName("flag", true)
+    .SetDefaultValue("true");
+
+  fMessenger->DeclareProperty("coneMultiplier", fConeMultiplier)
+    .SetGuidance("Neutrino opening angle kept, in units of 1/gamma of the parent.")
+    .SetParameterName("k", false)
+    .SetRange("k>0.");
+
+  fMessenger->DeclarePropertyWithUnit("maxCone", "rad", fMaxCone)
+    .SetGuidance("Always keep parents whose opening angle exceeds this.")
+    .SetParameterName("angle", false)
+    .SetRange("angle>0.");
+
+  fMessenger->DeclarePropertyWithUnit("halfWidthX", "m", fHalfWidthX)
+    .SetGuidance("Half width of the window in x on the projection plane.")
+    .SetParameterName("halfWidth", false)
+    .SetRange("halfWidth>0.");
+
+  fMessenger->DeclarePropertyWithUnit("halfWidthY", "m", fHalfWidthY)
+    .SetGuidance("Half width of the window in y on the projection plane.")
+    .SetParameterName("halfWidth", false)
+    .SetRange("halfWidth>0.");
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}  // namespace B1
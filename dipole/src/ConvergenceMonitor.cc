@@ -0,0 +1,296 @@
+/// \file B1/src/ConvergenceMonitor.cc
+/// \brief Implementation of the B1::ConvergenceMonitor class
+
+#include "ConvergenceMonitor.hh"
+
+#include "FluxWindow.hh"
+
+#include "G4AutoLock.hh"
+#include "G4GenericMessenger.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
+namespace B1
+{
+
+namespace
+{
+  G4Mutex totalsMutex = G4MUTEX_INITIALIZER;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+ConvergenceMonitor::ConvergenceMonitor()
+{
+  DefineCommands();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+ConvergenceMonitor::~ConvergenceMonitor()
+{
+  delete fMessenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ConvergenceMonitor::BeginOfRun(const std::vector<G4String>& columnNames, G4bool master)
+{
+  fNofBins = 0;
+  for (const auto& range : fRanges) fNofBins += range.nofBins;
+  fSumW.assign(fNofBins, 0.);
+  fSumW2.assign(fNofBins, 0.);
+  fEventW.assign(fNofBins, 0.);
+  fEventBins.clear();
+  fNofEvents = 0;
+
+  auto index = [&](const G4String& name) {
+    const auto it = std::find(columnNames.begin(), columnNames.end(), name);
+    return it == columnNames.end() ? -1 : static_cast<G4int>(it - columnNames.begin());
+  };
+  fWindowX = index("projXat574m");
+  fWindowY = index("projYat574m");
+
+  if (!master) return;
+  G4AutoLock lock(&totalsMutex);
+  Totals& totals = GetTotals();
+  totals = Totals();
+  totals.sumW.assign(fNofBins, 0.);
+  totals.sumW2.assign(fNofBins, 0.);
+  GetNofEvents().store(0);
+  GetStop().store(false);
+
+  for (const auto& range : fRanges) {
+    if (range.selection == kWindow && (fWindowX < 0 || fWindowY < 0)) {
+      G4ExceptionDescription msg;
+      msg << "Convergence bins " << range.label << ": the ff selection needs the at574m plane;"
+          << " they stay empty and the run only ends at its POT.";
+      G4Exception("ConvergenceMonitor::BeginOfRun()", "MIRAGE014", JustWarning, msg);
+    }
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ConvergenceMonitor::Fill(G4int pdg, G4double E, G4double pz, G4double weight,
+                              const G4double* columns)
+{
+  if (fNofBins == 0) return;
+
+  const G4bool forward = pz > 0.;
+  const G4bool inWindow = forward && fWindowX >= 0 && fWindowY >= 0 &&
+                          mirage::FluxWindow::Contains(columns[fWindowX], columns[fWindowY]);
+  G4int first = 0;
+  for (const auto& range : fRanges) {
+    const G4bool selected = (range.pdg == 0 || range.pdg == pdg) &&
+                            (range.selection != kForward || forward) &&
+                            (range.selection != kWindow || inWindow);
+    if (selected && E >= range.min && E < range.max) {
+      const G4int bin = first + static_cast<G4int>((E - range.min) / (range.max - range.min)
+                                                   * range.nofBins);
+      if (fEventW[bin] == 0.) fEventBins.push_back(bin);
+      fEventW[bin] += weight;
+    }
+    first += range.nofBins;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool ConvergenceMonitor::EndOfEvent()
+{
+  if (!IsEnabled()) return false;
+
+  // the event, not the row, is the independent sample
+  for (const G4int bin : fEventBins) {
+    fSumW[bin] += fEventW[bin];
+    fSumW2[bin] += fEventW[bin] * fEventW[bin];
+    fEventW[bin] = 0.;
+  }
+  fEventBins.clear();
+
+  if (GetStop().load(std::memory_order_relaxed)) return true;
+  const G4long nofEvents = GetNofEvents().fetch_add(1) + 1;
+  if (fMaxPOT > 0 && nofEvents >= fMaxPOT) {
+    GetStop().store(true);
+    return true;
+  }
+
+  if (++fNofEvents < fCheckEvery) return false;
+  Synchronise();
+  return GetStop().load();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ConvergenceMonitor::EndOfRun()
+{
+  if (IsEnabled()) Synchronise();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ConvergenceMonitor::Synchronise()
+{
+  G4AutoLock lock(&totalsMutex);
+  Totals& totals = GetTotals();
+  fNofEvents = 0;
+  if (fNofBins == 0 || static_cast<G4int>(totals.sumW.size()) != fNofBins) return;
+
+  // the bin with the largest relative uncertainty decides; empty bins
+  // have not converged
+  totals.worst = 0.;
+  totals.worstBin = -1;
+  for (G4int bin = 0; bin < fNofBins; ++bin) {
+    totals.sumW[bin] += fSumW[bin];
+    totals.sumW2[bin] += fSumW2[bin];
+    fSumW[bin] = 0.;
+    fSumW2[bin] = 0.;
+    const G4double error = totals.sumW[bin] > 0.
+                           ? std::sqrt(totals.sumW2[bin]) / totals.sumW[bin]
+                           : std::numeric_limits<G4double>::infinity();
+    if (totals.worstBin < 0 || error > totals.worst) {
+      totals.worst = error;
+      totals.worstBin = bin;
+    }
+  }
+  if (fPrecision > 0. && totals.worst <= fPrecision) {
+    totals.converged = true;
+    GetStop().store(true);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ConvergenceMonitor::PrintSummary(G4int nofEvents) const
+{
+  if (!IsEnabled()) return;
+
+  G4AutoLock lock(&totalsMutex);
+  const Totals& totals = GetTotals();
+  G4cout << " Convergence: " << nofEvents << " POT, ";
+  if (totals.converged) G4cout << "precision " << fPrecision << " reached";
+  else if (GetStop().load()) G4cout << "stopped at maxPOT " << fMaxPOT;
+  else G4cout << "not converged";
+  G4cout << G4endl;
+  if (totals.worstBin < 0) return;
+
+  // the range and energy interval of the worst bin
+  G4int first = 0;
+  for (const auto& range : fRanges) {
+    if (totals.worstBin < first + range.nofBins) {
+      const G4double width = (range.max - range.min) / range.nofBins;
+      const G4double low = range.min + (totals.worstBin - first) * width;
+      G4cout << "   worst bin " << range.label << " [" << low << ", " << low + width
+             << ") GeV: relative uncertainty " << totals.worst << G4endl;
+      return;
+    }
+    first += range.nofBins;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ConvergenceMonitor::AddBins(const G4String& args)
+{
+  std::istringstream is(args);
+  G4String flavour, selection;
+  Range range{};
+  G4bool valid = static_cast<bool>(is >> flavour >> selection >> range.nofBins
+                                      >> range.min >> range.max);
+
+  static const char* flavours[5] = {"all", "numu", "numubar", "nue", "nuebar"};
+  static const G4int pdgs[5] = {0, 14, -14, 12, -12};
+  const auto flavourIt = std::find(std::begin(flavours), std::end(flavours), flavour);
+  if (flavourIt == std::end(flavours)) valid = false;
+  else range.pdg = pdgs[flavourIt - std::begin(flavours)];
+
+  if (selection == "all") range.selection = kAll;
+  else if (selection == "forward") range.selection = kForward;
+  else if (selection == "ff") range.selection = kWindow;
+  else valid = false;
+
+  if (!valid || range.nofBins <= 0 || range.max <= range.min) {
+    G4ExceptionDescription msg;
+    msg << "Expected \"<flavour> <selection> <bins> <Emin> <Emax>\", got \"" << args << "\".";
+    G4Exception("ConvergenceMonitor::AddBins()", "MIRAGE014", JustWarning, msg);
+    return;
+  }
+  range.label = flavour + " " + selection;
+  fRanges.push_back(range);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ConvergenceMonitor::ClearBins()
+{
+  fRanges.clear();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+ConvergenceMonitor::Totals& ConvergenceMonitor::GetTotals()
+{
+  static Totals totals;
+  return totals;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+std::atomic<G4long>& ConvergenceMonitor::GetNofEvents()
+{
+  static std::atomic<G4long> nofEvents{0};
+  return nofEvents;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+std::atomic<bool>& ConvergenceMonitor::GetStop()
+{
+  static std::atomic<bool> stop{false};
+  return stop;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ConvergenceMonitor::DefineCommands()
+{
+  fMessenger = new G4GenericMessenger(this, "/mirage/convergence/", "Convergence-based run end");
+
+  fMessenger->DeclareMethod("bins", &ConvergenceMonitor::AddBins)
+    .SetGuidance("Monitor energy bins: <flavour> <selection> <bins> <Emin> <Emax> (GeV),")
+    .SetGuidance("flavour all, numu, numubar, nue or nuebar, selection all, forward or ff.")
+    .SetParameterName("bins", false)
+    .SetStates(G4State_PreInit, G4State_Idle);
+
+  fMessenger->DeclareMethod("clear", &ConvergenceMonitor::ClearBins)
+    .SetGuidance("Remove all monitored bins.")
+    .SetStates(G4State_PreInit, G4State_Idle);
+
+  fMessenger->DeclareProperty("precision", fPrecision)
+    .SetGuidance("End the run when the relative statistical uncertainty of every")
+    .SetGuidance("monitored bin is below this value; 0 disables.")
+    .SetParameterName("precision", false)
+    .SetRange("precision>=0")
+    .SetStates(G4State_PreInit, G4State_Idle);
+
+  fMessenger->DeclareProperty("maxPOT", fMaxPOT)
+    .SetGuidance("End the run after this many events at most; 0 for the /run/beamOn count.")
+    .SetParameterName("nofPOT", false)
+    .SetRange("nofPOT>=0")
+    .SetStates(G4State_PreInit, G4State_Idle);
+
+  fMessenger->DeclareProperty("checkEvery", fCheckEvery)
+    .SetGuidance("Events of a thread between two checks of the precision.")
+    .SetParameterName("nofEvents", false)
+    .SetRange("nofEvents>0")
+    .SetStates(G4State_PreInit, G4State_Idle);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}  // namespace B1
@@ -0,0 +1,155 @@
+/// \file B1/src/DecayBiasingOperator.cc
+/// \brief Implementation of the B1::DecayBiasingOperator class
+
+#include "DecayBiasingOperator.hh"
+
+#include "G4BiasingProcessInterface.hh"
+#include "G4BiasingProcessSharedData.hh"
+#include "G4BOptnChangeCrossSection.hh"
+#include "G4GenericMessenger.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4ParticleTable.hh"
+#include "G4ProcessManager.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4Track.hh"
+
+#include <sstream>
+
+namespace B1
+{
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+DecayBiasingOperator::DecayBiasingOperator()
+  : G4VBiasingOperator("DecayBiasingOperator"),
+    fDecayLength(50. * m),
+    fSpecies{211, -211, 321, -321, 130}
+{
+  DefineCommands();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+DecayBiasingOperator::~DecayBiasingOperator()
+{
+  for (auto& entry : fOperations) delete entry.second;
+  delete fMessenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DecayBiasingOperator::StartRun()
+{
+  // One operation per wrapped decay process of this thread
+  if (!fOperations.empty()) return;
+
+  auto particleIterator = G4ParticleTable::GetParticleTable()->GetIterator();
+  particleIterator->reset();
+  while ((*particleIterator)()) {
+    const G4ProcessManager* processManager = particleIterator->value()->GetProcessManager();
+    if (!processManager) continue;
+    const G4BiasingProcessSharedData* sharedData =
+      G4BiasingProcessInterface::GetSharedData(processManager);
+    if (!sharedData) continue;
+    for (const auto wrapper : sharedData->GetPhysicsBiasingProcessInterfaces()) {
+      if (fOperations.count(wrapper)) continue;
+      fOperations[wrapper] = new G4BOptnChangeCrossSection(
+        "XSchange-" + wrapper->GetWrappedProcess()->GetProcessName());
+    }
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4VBiasingOperation* DecayBiasingOperator::ProposeOccurenceBiasingOperation(
+  const G4Track* track, const G4BiasingProcessInterface* callingProcess)
+{
+  if (!fEnabled || !IsSelected(track->GetDefinition()->GetPDGEncoding())) return nullptr;
+
+  auto found = fOperations.find(callingProcess);
+  if (found == fOperations.end()) return nullptr;
+
+  const G4double analogLength = callingProcess->GetWrappedProcess()->GetCurrentInteractionLength();
+  if (analogLength > DBL_MAX / 10.) return nullptr;
+  // only shorten the decay length, never lengthen it
+  if (analogLength <= fDecayLength) return nullptr;
+
+  const G4double biasedCrossSection = 1. / fDecayLength;
+  G4BOptnChangeCrossSection* operation = found->second;
+  G4VBiasingOperation* previousOperation = callingProcess->GetPreviousOccurenceBiasingOperation();
+
+  if (previousOperation != operation || operation->GetInteractionOccured()) {
+    // new track, or the previous decay length was used up: sample afresh
+    operation->SetBiasedCrossSection(biasedCrossSection);
+    operation->Sample();
+  }
+  else {
+    // continuing track: consume the previous step, keep the sampled point
+    operation->UpdateForStep(callingProcess->GetPreviousStepSize());
+    operation->SetBiasedCrossSection(biasedCrossSection);
+    operation->UpdateForStep(0.0);
+  }
+
+  return operation;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DecayBiasingOperator::OperationApplied(const G4BiasingProcessInterface* callingProcess,
+                                            G4BiasingAppliedCase,
+                                            G4VBiasingOperation* occurenceOperationApplied,
+                                            G4double,
+                                            G4VBiasingOperation*,
+                                            const G4VParticleChange*)
+{
+  auto found = fOperations.find(callingProcess);
+  if (found == fOperations.end()) return;
+  if (found->second == occurenceOperationApplied) found->second->SetInteractionOccured();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool DecayBiasingOperator::IsSelected(G4int pdg) const
+{
+  for (auto species : fSpecies) {
+    if (species == pdg) return true;
+  }
+  return false;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DecayBiasingOperator::SetSpecies(const G4String& pdgList)
+{
+  fSpecies.clear();
+  std::istringstream is(pdgList);
+  G4int pdg = 0;
+  while (is >> pdg) fSpecies.push_back(pdg);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DecayBiasingOperator::DefineCommands()
+{
+  fMessenger = new G4GenericMessenger(this, "/mirage/biasing/", "Decay biasing control");
+
+  fMessenger->DeclareProperty("enable", fEnabled)
+    .SetGuidance("Bias the decay of the selected species (needs --bias-decay).")
+    .SetParameterName("flag", true)
+    .SetDefaultValue("true");
+
+  fMessenger->DeclarePropertyWithUnit("decayLength", "m", fDecayLength)
+    .SetGuidance("Mean decay length the selected species are biased to,")
+    .SetGuidance("when it is shorter than their analog one.")
+    .SetParameterName("length", false)
+    .SetRange("length>0.");
+
+  fMessenger->DeclareMethod("species", &DecayBiasingOperator::SetSpecies)
+    .SetGuidance("PDG codes of the biased species (default: 211 -211 321 -321 130).")
+    .SetGuidance("Only these can be biased, the decay of others is not wrapped.")
+    .SetParameterName("pdgList", false);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}  // namespace B1
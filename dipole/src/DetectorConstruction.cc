@@ -10,6 +10,17 @@
 #include "G4PVPlacement.hh"
 #include "G4SystemOfUnits.hh"
 #include "G4PhysicalConstants.hh"
+#include "G4SubtractionSolid.hh"
+#include "G4Region.hh"
+#include "G4RegionStore.hh"
+#include "G4ProductionCuts.hh"
+#include "G4UIcommand.hh"
+#include "G4GenericMessenger.hh"
+#include "G4LogicalVolumeStore.hh"
+#include "G4AutoDelete.hh"
+
+// Biasing
+#include "DecayBiasingOperator.hh"
 
 // Magnetic Fields
 #include "SimpleHornMagneticField.hh"
@@ -27,29 +38,67 @@
 #include "G4VisAttributes.hh"
 #include "G4Colour.hh"
 
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <sstream>
+
+namespace
+{
+  // 자기장 볼륨 하나의 스레드별 객체: stepper와 chord finder는 적분 상태를
+  // 가지므로 스레드 사이에 공유할 수 없음 (삭제는 선언의 역순)
+  struct MagnetField
+  {
+    std::unique_ptr<G4UniformMagField> field;
+    std::unique_ptr<G4Mag_UsualEqRhs> equation;
+    std::unique_ptr<G4MagIntegratorStepper> stepper;
+    std::unique_ptr<G4ChordFinder> chordFinder;
+    std::unique_ptr<G4FieldManager> fieldManager;
+  };
+
+  // 이 스레드의 자기장; geometry를 다시 만들면 교체, 스레드가 끝날 때 삭제
+  G4ThreadLocal std::vector<MagnetField>* threadFields = nullptr;
+
+  MagnetField MakeDipoleField(const G4ThreeVector& B)
+  {
+    MagnetField magnet;
+    magnet.field.reset(new G4UniformMagField(B));
+    magnet.equation.reset(new G4Mag_UsualEqRhs(magnet.field.get()));
+    magnet.stepper.reset(new G4ClassicalRK4(magnet.equation.get()));
+    //magnet.stepper.reset(new G4DormandPrince745(magnet.equation.get()));
+    G4double minStep = 0.5 * mm;
+    magnet.chordFinder.reset(new G4ChordFinder(magnet.field.get(), minStep, magnet.stepper.get()));
+
+    magnet.fieldManager.reset(new G4FieldManager());
+    magnet.fieldManager->SetDetectorField(magnet.field.get());
+    magnet.fieldManager->SetChordFinder(magnet.chordFinder.get());
+    magnet.fieldManager->SetDeltaOneStep(0.5 * mm);
+    magnet.fieldManager->SetDeltaIntersection(0.1 * mm);
+    return magnet;
+  }
+}
+
 DetectorConstruction::DetectorConstruction()
 : G4VUserDetectorConstruction(),
-  fMagFieldA(nullptr), fMagFieldB(nullptr), fMagFieldC(nullptr),
-  fFieldMgrA(nullptr), fFieldMgrB(nullptr), fFieldMgrC(nullptr),
   logicInnerCondA(nullptr), logicFieldRegionA(nullptr), logicOuterCondA(nullptr),
   logicInnerCondB(nullptr), logicFieldRegionB(nullptr), logicOuterCondB(nullptr),
-  logicInnerCondC(nullptr), logicFieldRegionC(nullptr), logicOuterCondC(nullptr)
+  logicInnerCondC(nullptr), logicFieldRegionC(nullptr), logicOuterCondC(nullptr),
+  fMessenger(nullptr), fEnvelope(false), fDecayPipeRadius(2.0 * m), fAbsorberZ(0.),
+  fDecayBiasing(false)
 {
+  DefineCommands();
 }
 
 DetectorConstruction::~DetectorConstruction()
 {
-  delete fMagFieldA;
-  delete fMagFieldB;
-  delete fMagFieldC;
-  delete fFieldMgrA;
-  delete fFieldMgrB;
-  delete fFieldMgrC;
+  delete fMessenger;
 }
 
 G4VPhysicalVolume* DetectorConstruction::Construct()
 {
   G4VPhysicalVolume* physWorld = nullptr;
+  fFieldRegionBounds.clear();
+  fMagnets.clear();
 
   // 1. Construct World
   ConstructWorld(physWorld);
@@ -57,6 +106,10 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
   // Get world logical volume
   G4LogicalVolume* logicWorld = physWorld->GetLogicalVolume();
 
+  // 월드 영역의 tracking floor (/mirage/geometry/minEkine DefaultRegionForTheWorld ...)
+  G4Region* worldRegion = G4RegionStore::GetInstance()->GetRegion("DefaultRegionForTheWorld", false);
+  if (worldRegion && !worldRegion->GetUserLimits()) worldRegion->SetUserLimits(new G4UserLimits());
+
   ConstructTarget(logicWorld);
 
   // 2. Construct Horn Geometry and Magnetic Fields
@@ -71,9 +124,36 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
 
   // (Optional) Additional geometry components can be constructed here
 
+  // 3. 빔라인 바깥을 kill 볼륨으로 덮음 (선택 사항)
+  if (fEnvelope) ConstructEnvelope(logicWorld);
+
   return physWorld;
 }
 
+void DetectorConstruction::ConstructSDandField()
+{
+  // 스레드(마스터와 각 워커)마다 자기장, stepper, chord finder, field manager를 생성
+  std::vector<MagnetField> fields;
+  for (const auto& magnet : fMagnets) {
+    fields.push_back(MakeDipoleField(magnet.field));
+    magnet.volume->SetFieldManager(fields.back().fieldManager.get(), true);
+  }
+  if (!threadFields) {
+    threadFields = new std::vector<MagnetField>();
+    G4AutoDelete::Register(threadFields);
+  }
+  // 이전 geometry의 객체는 새 field manager가 붙은 뒤 여기서 삭제
+  threadFields->swap(fields);
+
+  if (!fDecayBiasing) return;
+
+  // 월드 볼륨(decay 영역)에서만 decay를 biasing; 타겟과 자석 안은 analog
+  // operator는 워커마다 하나씩 생성됨
+  G4LogicalVolume* logicWorld = G4LogicalVolumeStore::GetInstance()->GetVolume("LogicWorld");
+  auto biasingOperator = new B1::DecayBiasingOperator();
+  biasingOperator->AttachTo(logicWorld);
+}
+
 void DetectorConstruction::ConstructWorld(G4VPhysicalVolume*& physWorld)
 {
   G4NistManager* nist = G4NistManager::Instance();
@@ -124,6 +204,10 @@ void DetectorConstruction::ConstructTarget(G4LogicalVolume* logicWorld)
                     logicWorld,
                     false,
                     0);
+
+  // 타겟 영역: EM 샤워 비용이 가장 큰 곳
+  G4Region* targetRegion = CreateRegion("Target");
+  targetRegion->AddRootLogicalVolume(logicTarget);
 }
 
 void DetectorConstruction::ConstructDipoleA(G4LogicalVolume* logicWorld) {
@@ -146,31 +230,19 @@ void DetectorConstruction::ConstructDipoleA(G4LogicalVolume* logicWorld) {
   G4double Bx = Bmag * std::sin(angleRad);
   G4double By = Bmag * std::cos(angleRad);
   G4double Bz = 0.0;
-  G4UniformMagField* magField = new G4UniformMagField(G4ThreeVector(Bx, By, Bz));
-
-  G4FieldManager* fieldMgr = new G4FieldManager();
-  fieldMgr->SetDetectorField(magField);
-  G4Mag_UsualEqRhs* fEquation = new G4Mag_UsualEqRhs(magField);
-  G4MagIntegratorStepper* fStepper = new G4ClassicalRK4(fEquation);
-  //G4MagIntegratorStepper* fStepper = new G4DormandPrince745(fEquation);
-  G4double minStep = 0.5 * mm;
-
-  G4ChordFinder* fChordFinder = new G4ChordFinder(magField, minStep, fStepper);
-  fieldMgr->SetChordFinder(fChordFinder);
-
-  fieldMgr->SetDeltaOneStep(0.5 * mm);
-  fieldMgr->SetDeltaIntersection(0.1 * mm);
-
-  logicDipole->SetFieldManager(fieldMgr, true);
+  fFieldRegionBounds.push_back({zpos - 0.5 * sizeZ, zpos + 0.5 * sizeZ, std::abs(Bmag) * sizeZ});
+  // 자기장은 ConstructSDandField()에서 스레드마다 생성
+  fMagnets.push_back({logicDipole, G4ThreeVector(Bx, By, Bz)});
 
   // --- VisAttributes
   G4VisAttributes* visAttrInner = new G4VisAttributes(G4Colour(0.5, 0.5, 0.5)); // Grey
   logicDipole->SetVisAttributes(visAttrInner);
 
-  // --- Step Limiter (optional)
-  G4UserLimits* userLimits = new G4UserLimits();
-  userLimits->SetMaxAllowedStep(10.0 * mm);
-  logicDipole->SetUserLimits(userLimits);
+  // --- Region: production cuts, tracking floor, step limiter (optional)
+  // (영역의 G4UserLimits를 쓰도록 볼륨 자체에는 limits를 두지 않음)
+  G4Region* region = CreateRegion("DipoleA");
+  region->AddRootLogicalVolume(logicDipole);
+  region->GetUserLimits()->SetMaxAllowedStep(10.0 * mm);
 }
 
 void DetectorConstruction::ConstructDipoleB(G4LogicalVolume* logicWorld) {
@@ -191,30 +263,18 @@ void DetectorConstruction::ConstructDipoleB(G4LogicalVolume* logicWorld) {
   G4double Bx = Bmag * std::sin(angleRad);
   G4double By = Bmag * std::cos(angleRad);
   G4double Bz = 0.0;
-  G4UniformMagField* magField = new G4UniformMagField(G4ThreeVector(Bx, By, Bz));
-
-  G4FieldManager* fieldMgr = new G4FieldManager();
-  fieldMgr->SetDetectorField(magField);
-  G4Mag_UsualEqRhs* fEquation = new G4Mag_UsualEqRhs(magField);
-  G4MagIntegratorStepper* fStepper = new G4ClassicalRK4(fEquation);
-  //G4MagIntegratorStepper* fStepper = new G4DormandPrince745(fEquation);
-  G4double minStep = 0.5 * mm;
-
-  G4ChordFinder* fChordFinder = new G4ChordFinder(magField, minStep, fStepper);
-  fieldMgr->SetChordFinder(fChordFinder);
-
-  fieldMgr->SetDeltaOneStep(0.5 * mm);
-  fieldMgr->SetDeltaIntersection(0.1 * mm);
-
-  logicDipole->SetFieldManager(fieldMgr, true);
+  fFieldRegionBounds.push_back({zpos - 0.5 * sizeZ, zpos + 0.5 * sizeZ, std::abs(Bmag) * sizeZ});
+  // 자기장은 ConstructSDandField()에서 스레드마다 생성
+  fMagnets.push_back({logicDipole, G4ThreeVector(Bx, By, Bz)});
   // --- VisAttributes
   G4VisAttributes* visAttrInner = new G4VisAttributes(G4Colour(0.5, 0.5, 0.5)); // Grey
   logicDipole->SetVisAttributes(visAttrInner);
 
-  // --- Step Limiter (optional)
-  G4UserLimits* userLimits = new G4UserLimits();
-  userLimits->SetMaxAllowedStep(10.0 * mm);
-  logicDipole->SetUserLimits(userLimits);
+  // --- Region: production cuts, tracking floor, step limiter (optional)
+  // (영역의 G4UserLimits를 쓰도록 볼륨 자체에는 limits를 두지 않음)
+  G4Region* region = CreateRegion("DipoleB");
+  region->AddRootLogicalVolume(logicDipole);
+  region->GetUserLimits()->SetMaxAllowedStep(10.0 * mm);
 }
 
 void DetectorConstruction::ConstructDipoleC(G4LogicalVolume* logicWorld) {
@@ -235,28 +295,134 @@ void DetectorConstruction::ConstructDipoleC(G4LogicalVolume* logicWorld) {
   G4double Bx = Bmag * std::sin(angleRad);
   G4double By = Bmag * std::cos(angleRad);
   G4double Bz = 0.0;
-  G4UniformMagField* magField = new G4UniformMagField(G4ThreeVector(Bx, By, Bz));
+  fFieldRegionBounds.push_back({zpos - 0.5 * sizeZ, zpos + 0.5 * sizeZ, std::abs(Bmag) * sizeZ});
+  // 자기장은 ConstructSDandField()에서 스레드마다 생성
+  fMagnets.push_back({logicDipole, G4ThreeVector(Bx, By, Bz)});
+  // --- VisAttributes
+  G4VisAttributes* visAttrInner = new G4VisAttributes(G4Colour(0.5, 0.5, 0.5)); // Grey
+  logicDipole->SetVisAttributes(visAttrInner);
 
-  G4FieldManager* fieldMgr = new G4FieldManager();
-  fieldMgr->SetDetectorField(magField);
-  G4Mag_UsualEqRhs* fEquation = new G4Mag_UsualEqRhs(magField);
-  G4MagIntegratorStepper* fStepper = new G4ClassicalRK4(fEquation); 
-  //G4MagIntegratorStepper* fStepper = new G4DormandPrince745(fEquation);
-  G4double minStep = 0.5 * mm;
+  // --- Region: production cuts, tracking floor, step limiter (optional)
+  // (영역의 G4UserLimits를 쓰도록 볼륨 자체에는 limits를 두지 않음)
+  G4Region* region = CreateRegion("DipoleC");
+  region->AddRootLogicalVolume(logicDipole);
+  region->GetUserLimits()->SetMaxAllowedStep(10.0 * mm);
+}
 
-  G4ChordFinder* fChordFinder = new G4ChordFinder(magField, minStep, fStepper);
-  fieldMgr->SetChordFinder(fChordFinder);
+void DetectorConstruction::ConstructEnvelope(G4LogicalVolume* logicWorld)
+{
+  // 월드 박스에서 decay pipe 원통을 뺀 영역을 kill 볼륨으로 둡니다.
+  // fAbsorberZ > 0 이면 pipe가 그 위치(월드 상류면 기준)에서 끝나므로
+  // 그 하류 전체가 흡수체(absorber) 역할을 합니다.
+  G4Box* solidWorld = dynamic_cast<G4Box*>(logicWorld->GetSolid());
+  G4double worldHalfZ = solidWorld->GetZHalfLength();
+  G4double margin = 1.0 * m; // 월드 면과 겹치는 면(coincident surface)을 피하기 위한 여유
+  G4double pipeEndZ = (fAbsorberZ > 0.) ? -worldHalfZ + fAbsorberZ : worldHalfZ + margin;
+
+  // 빔라인 요소(타겟, 혼/다이폴)가 모두 pipe 안에 있어야 합니다.
+  for (std::size_t i = 0; i < logicWorld->GetNoDaughters(); ++i) {
+    G4VPhysicalVolume* daughter = logicWorld->GetDaughter(i);
+    G4ThreeVector pMin, pMax;
+    daughter->GetLogicalVolume()->GetSolid()->BoundingLimits(pMin, pMax);
+    pMin += daughter->GetTranslation();
+    pMax += daughter->GetTranslation();
+    G4double xMax = std::max(std::abs(pMin.x()), std::abs(pMax.x()));
+    G4double yMax = std::max(std::abs(pMin.y()), std::abs(pMax.y()));
+    if (std::sqrt(xMax * xMax + yMax * yMax) > fDecayPipeRadius || pMax.z() > pipeEndZ) {
+      G4ExceptionDescription msg;
+      msg << daughter->GetName() << " does not fit inside the beamline envelope"
+          << " (decay pipe radius " << fDecayPipeRadius / m << " m, end at z = "
+          << pipeEndZ / m << " m).";
+      G4Exception("DetectorConstruction::ConstructEnvelope()", "MIRAGE004",
+                  FatalException, msg);
+    }
+  }
+
+  G4double pipeHalfZ = 0.5 * (pipeEndZ + worldHalfZ + margin);
+  G4Tubs* solidPipe = new G4Tubs("SolidDecayPipe",
+                                 0.0,
+                                 fDecayPipeRadius,
+                                 pipeHalfZ,
+                                 0.0 * deg,
+                                 360.0 * deg);
+  G4SubtractionSolid* solidEnvelope = new G4SubtractionSolid("SolidEnvelope",
+                                                             solidWorld,
+                                                             solidPipe,
+                                                             nullptr,
+                                                             G4ThreeVector(0., 0., pipeEndZ - pipeHalfZ));
+  G4LogicalVolume* logicEnvelope = new G4LogicalVolume(solidEnvelope,
+                                                       logicWorld->GetMaterial(),
+                                                       "LogicEnvelope");
+  new G4PVPlacement(0, G4ThreeVector(), logicEnvelope, "PhysEnvelope", logicWorld, false, 0);
+  logicEnvelope->SetVisAttributes(G4VisAttributes::GetInvisible());
+
+  // KillRegion: 최소 운동에너지 DBL_MAX → G4UserSpecialCuts가 첫 스텝에서 트랙을 제거
+  G4Region* killRegion = new G4Region("KillRegion");
+  killRegion->AddRootLogicalVolume(logicEnvelope);
+  killRegion->SetUserLimits(new G4UserLimits(DBL_MAX, DBL_MAX, DBL_MAX, DBL_MAX));
+}
 
-  fieldMgr->SetDeltaOneStep(0.5 * mm);
-  fieldMgr->SetDeltaIntersection(0.1 * mm);
+G4Region* DetectorConstruction::CreateRegion(const G4String& name)
+{
+  // 월드의 기본 cut으로 시작하며 /run/setCutForRegion 으로 바꿀 수 있습니다.
+  // tracking floor (minEkine)는 G4UserSpecialCuts가 적용합니다.
+  G4Region* region = new G4Region(name);
+  G4Region* worldRegion = G4RegionStore::GetInstance()->GetRegion("DefaultRegionForTheWorld", false);
+  if (worldRegion && worldRegion->GetProductionCuts()) {
+    region->SetProductionCuts(new G4ProductionCuts(*worldRegion->GetProductionCuts()));
+  }
+  region->SetUserLimits(new G4UserLimits());
+  return region;
+}
 
-  logicDipole->SetFieldManager(fieldMgr, true);
-  // --- VisAttributes
-  G4VisAttributes* visAttrInner = new G4VisAttributes(G4Colour(0.5, 0.5, 0.5)); // Grey
-  logicDipole->SetVisAttributes(visAttrInner);
+void DetectorConstruction::SetRegionMinEkine(const G4String& args)
+{
+  // "<region> <value> <unit>"
+  std::istringstream is(args);
+  G4String name, unit;
+  G4double value = 0.;
+  is >> name >> value >> unit;
+
+  G4Region* region = G4RegionStore::GetInstance()->GetRegion(name, false);
+  if (is.fail() || !region || !region->GetUserLimits()) {
+    G4ExceptionDescription msg;
+    msg << "Cannot set the tracking floor of region <" << name << ">"
+        << " (usage: <region> <value> <unit>, after /run/initialize).";
+    G4Exception("DetectorConstruction::SetRegionMinEkine()", "MIRAGE005",
+                JustWarning, msg);
+    return;
+  }
+  region->GetUserLimits()->SetUserMinEkine(value * G4UIcommand::ValueOf(unit.c_str()));
+}
 
-  // --- Step Limiter (optional)
-  G4UserLimits* userLimits = new G4UserLimits();
-  userLimits->SetMaxAllowedStep(10.0 * mm);
-  logicDipole->SetUserLimits(userLimits);
+void DetectorConstruction::DefineCommands()
+{
+  fMessenger = new G4GenericMessenger(this, "/mirage/geometry/", "Geometry control");
+
+  fMessenger->DeclareProperty("envelope", fEnvelope)
+    .SetGuidance("Kill tracks that leave the decay pipe or pass the absorber.")
+    .SetGuidance("Needs SpecialCutsPhysics; set before /run/initialize.")
+    .SetParameterName("flag", true)
+    .SetDefaultValue("true")
+    .SetStates(G4State_PreInit);
+
+  fMessenger->DeclarePropertyWithUnit("decayPipeRadius", "m", fDecayPipeRadius)
+    .SetGuidance("Radius of the beamline envelope around the beam axis.")
+    .SetParameterName("radius", false)
+    .SetRange("radius>0.")
+    .SetStates(G4State_PreInit);
+
+  fMessenger->DeclarePropertyWithUnit("absorberZ", "m", fAbsorberZ)
+    .SetGuidance("Absorber plane, measured from the upstream face of the world.")
+    .SetGuidance("Everything downstream of it is killed; 0 disables the absorber.")
+    .SetParameterName("z", false)
+    .SetRange("z>=0.")
+    .SetStates(G4State_PreInit);
+
+  fMessenger->DeclareMethod("minEkine", &DetectorConstruction::SetRegionMinEkine)
+    .SetGuidance("Tracking floor of a region: kill any track below this kinetic energy.")
+    .SetGuidance("Usage: minEkine <region> <value> <unit>, e.g. minEkine Target 10 MeV")
+    .SetGuidance("Regions: Target, Dipole/Horn A-C, DefaultRegionForTheWorld.")
+    .SetParameterName("args", false)
+    .SetStates(G4State_Idle);
 }
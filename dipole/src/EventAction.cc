@@ -29,8 +29,12 @@
 
 #include "EventAction.hh"
 
+#include "OutputBuffer.hh"
 #include "RunAction.hh"
 
+#include "G4Event.hh"
+#include "G4SystemOfUnits.hh"
+
 namespace B1
 {
 
@@ -40,14 +44,31 @@ EventAction::EventAction(RunAction* runAction) : fRunAction(runAction) {}
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-void EventAction::BeginOfEventAction(const G4Event*)
+void EventAction::BeginOfEventAction(const G4Event* event)
+{
+  fEventID = event->GetEventID();
+  fNofDecays = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void EventAction::EndOfEventAction(const G4Event* event)
 {
+  fRunAction->EndOfEvent(event->GetEventID());
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-void EventAction::EndOfEventAction(const G4Event*)
+OutputBuffer* EventAction::BeginDecay(G4int parentPDG, const G4ThreeVector& parentMom,
+                                      G4double parentE, const G4ThreeVector& decayPos,
+                                      std::size_t nofNeutrinos)
 {
+  OutputBuffer* buffer = fRunAction->GetOutputWriter()->Reserve(nofNeutrinos);
+  const G4double parent[7] = {parentMom.x() / GeV, parentMom.y() / GeV, parentMom.z() / GeV,
+                              parentE / GeV, decayPos.x() / m, decayPos.y() / m,
+                              decayPos.z() / m};
+  buffer->AddParent(fEventID, fNofDecays++, parentPDG, parent);
+  return buffer;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,157 @@
+/// \file B1/src/EventSeeds.cc
+/// \brief Implementation of the B1::EventSeeds class
+
+#include "EventSeeds.hh"
+
+#include "PhiloxEngine.hh"
+
+#include "G4GenericMessenger.hh"
+#include "Randomize.hh"
+
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <utility>
+
+namespace B1
+{
+
+namespace
+{
+  // numbers drawn per event in the per-event cost of the benchmark
+  const G4int kBenchmarkDraws = 1000;
+
+  std::uint64_t SplitMix64(std::uint64_t x)
+  {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+  }
+
+  G4double NanosecondsSince(std::chrono::steady_clock::time_point start, G4long n)
+  {
+    return std::chrono::duration<G4double, std::nano>(std::chrono::steady_clock::now() - start)
+             .count() / n;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+EventSeeds::EventSeeds()
+{
+  DefineCommands();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+EventSeeds::~EventSeeds()
+{
+  delete fMessenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void EventSeeds::BeginOfRun(G4int nofEvents)
+{
+  fRunFirstEvent = fFirstEvent + fNofJobEvents;
+  fNofJobEvents += nofEvents;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void EventSeeds::Reseed(G4int eventID) const
+{
+  long seeds[3];
+  GetSeeds(fRunSeed, fRunFirstEvent + eventID, seeds);
+  G4Random::getTheEngine()->setSeeds(seeds, 2);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void EventSeeds::GetSeeds(G4long runSeed, G4long event, long seeds[3])
+{
+  // two non-zero 31-bit words, as Geant4 seeds the events of its workers
+  const std::uint64_t hash = SplitMix64(SplitMix64(runSeed) ^ static_cast<std::uint64_t>(event));
+  seeds[0] = static_cast<long>(hash & 0x7fffffff) + 1;
+  seeds[1] = static_cast<long>((hash >> 32) & 0x7fffffff) + 1;
+  seeds[2] = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void EventSeeds::RunBenchmark() const
+{
+  if (fBenchmarkEvents <= 0) return;
+
+  CLHEP::MTwistEngine mtwist;
+  CLHEP::MixMaxRng mixmax;
+  mirage::PhiloxEngine philox;
+  const std::pair<const char*, CLHEP::HepRandomEngine*> engines[] = {
+    {"mtwist", &mtwist}, {"mixmax", &mixmax}, {"philox", &philox}
+  };
+
+  G4cout
+    << G4endl
+    << "--------------------Random engine benchmark-----------------" << G4endl
+    << " events: " << fBenchmarkEvents << "  (per-event cost at " << kBenchmarkDraws
+    << " numbers)" << G4endl
+    << std::fixed << std::setprecision(2);
+
+  volatile G4double sink = 0.;
+  for (const auto& engine : engines) {
+    long seeds[3];
+    auto start = std::chrono::steady_clock::now();
+    for (G4long event = 0; event < fBenchmarkEvents; ++event) {
+      GetSeeds(fRunSeed, event, seeds);
+      engine.second->setSeeds(seeds, 2);
+      sink = sink + engine.second->flat();
+    }
+    const G4double reseed = NanosecondsSince(start, fBenchmarkEvents);
+
+    const G4long nofNumbers = fBenchmarkEvents * kBenchmarkDraws;
+    start = std::chrono::steady_clock::now();
+    for (G4long i = 0; i < nofNumbers; ++i) sink = sink + engine.second->flat();
+    const G4double number = NanosecondsSince(start, nofNumbers);
+
+    G4cout
+      << " " << std::setw(7) << std::left << engine.first << std::right
+      << " reseed: " << std::setw(9) << reseed << " ns"
+      << "   flat: " << std::setw(6) << number << " ns"
+      << "   per event: " << std::setw(8) << (reseed + kBenchmarkDraws * number) / 1000. << " us"
+      << G4endl;
+  }
+  G4cout
+    << std::defaultfloat
+    << "------------------------------------------------------------" << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void EventSeeds::DefineCommands()
+{
+  fMessenger = new G4GenericMessenger(this, "/mirage/random/", "Random number streams");
+
+  fMessenger->DeclareProperty("perEvent", fPerEvent)
+    .SetGuidance("Reseed every event from (seed, event number), so that the events do")
+    .SetGuidance("not depend on the thread count and can be rerun alone.")
+    .SetParameterName("perEvent", false)
+    .SetStates(G4State_PreInit, G4State_Idle);
+
+  fMessenger->DeclareProperty("firstEvent", fFirstEvent)
+    .SetGuidance("Event number of the first event of the job (perEvent); with")
+    .SetGuidance("/run/beamOn 1 it reruns that event alone.")
+    .SetParameterName("event", false)
+    .SetRange("event>=0")
+    .SetStates(G4State_PreInit, G4State_Idle);
+
+  fMessenger->DeclareProperty("benchmark", fBenchmarkEvents)
+    .SetGuidance("Time the reseeding and the numbers of the MTwist, MixMax and Philox")
+    .SetGuidance("engines at the start of each run; 0 disables the benchmark.")
+    .SetParameterName("nofEvents", false)
+    .SetDefaultValue("0");
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}  // namespace B1
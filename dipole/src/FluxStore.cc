@@ -0,0 +1,174 @@
+/// \file B1/src/FluxStore.cc
+/// \brief Implementation of the B1::FluxStore class
+
+#include "FluxStore.hh"
+
+#include "OutputBuffer.hh"
+#include "RunManifest.hh"
+
+#include <algorithm>
+#include <cstring>
+
+namespace B1
+{
+
+namespace
+{
+  const char* kParentColumns[7] = {"parentPx", "parentPy", "parentPz", "parentE",
+                                   "vertexX", "vertexY", "vertexZ"};
+  const char* kNeutrinoColumns[4] = {"daughterE", "daughterPx", "daughterPy", "daughterPz"};
+
+  const char kPadding[8] = {};
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+FluxStore::~FluxStore()
+{
+  if (IsOpen()) Close(0);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void FluxStore::Open(const G4String& partName, const std::vector<G4String>& extraNames)
+{
+  if (IsOpen()) Close(0);
+
+  G4String fileName = RunManifest::GetPartName(partName);
+  fileName.erase(fileName.size() - 5);
+  fileName += ".flux";
+
+  fFile.open(fileName, std::ios::binary | std::ios::trunc);
+  if (!fFile) {
+    G4ExceptionDescription msg;
+    msg << "Cannot open the flux file " << fileName << "; its rows are only in the ROOT file.";
+    G4Exception("FluxStore::Open()", "MIRAGE012", JustWarning, msg);
+    return;
+  }
+
+  // the column order of the flat ntuple
+  fColumns.clear();
+  AddColumn("event", mirage::kFluxInt32);
+  AddColumn("parent", mirage::kFluxInt32);
+  AddColumn("parentPDG", mirage::kFluxInt32);
+  for (const char* name : kParentColumns) AddColumn(name, mirage::kFluxFloat64);
+  AddColumn("daughterPDG", mirage::kFluxInt32);
+  for (const char* name : kNeutrinoColumns) AddColumn(name, mirage::kFluxFloat64);
+  AddColumn("weight", mirage::kFluxFloat64);
+  for (const auto& name : extraNames) AddColumn(name, mirage::kFluxFloat64);
+
+  fBlocks.clear();
+  fStats.clear();
+  fNofRows = 0;
+
+  // header placeholder, rewritten by Close()
+  mirage::FluxFileHeader header{};
+  fFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  fFile.write(reinterpret_cast<const char*>(fColumns.data()),
+              fColumns.size() * sizeof(mirage::FluxColumnInfo));
+  fOffset = sizeof(header) + fColumns.size() * sizeof(mirage::FluxColumnInfo);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void FluxStore::Write(const OutputBuffer& buffer)
+{
+  const std::size_t nofRows = buffer.nofRows;
+  if (!IsOpen() || nofRows == 0) return;
+
+  std::uint32_t flavours = 0;
+  for (std::size_t r = 0; r < nofRows; ++r) {
+    flavours |= mirage::FluxFile::FlavourBit(buffer.rowPDG[r]);
+  }
+  fBlocks.push_back({fOffset, nofRows, flavours, 0});
+  fNofRows += nofRows;
+  fIntColumn.resize(nofRows);
+  fDoubleColumn.resize(nofRows);
+
+  // parent columns, repeated for each of its neutrinos
+  for (const auto* column : {&buffer.parentEvent, &buffer.parentIndex, &buffer.parentPDG}) {
+    for (std::size_t r = 0; r < nofRows; ++r) {
+      fIntColumn[r] = (*column)[buffer.rowParent[r]];
+    }
+    WriteColumn(fIntColumn.data(), nofRows);
+  }
+  for (const auto& column : buffer.parentValues) {
+    for (std::size_t r = 0; r < nofRows; ++r) {
+      fDoubleColumn[r] = column[buffer.rowParent[r]];
+    }
+    WriteColumn(fDoubleColumn.data(), nofRows);
+  }
+
+  WriteColumn(buffer.rowPDG.data(), nofRows);
+  WriteColumn(buffer.rowE.data(), nofRows);
+  WriteColumn(buffer.rowPx.data(), nofRows);
+  WriteColumn(buffer.rowPy.data(), nofRows);
+  WriteColumn(buffer.rowPz.data(), nofRows);
+  WriteColumn(buffer.rowWeight.data(), nofRows);
+
+  // the plane and location columns are interleaved per row in the buffer
+  for (std::size_t c = 0; c < buffer.nofExtraColumns; ++c) {
+    for (std::size_t r = 0; r < nofRows; ++r) {
+      fDoubleColumn[r] = buffer.extra[r * buffer.nofExtraColumns + c];
+    }
+    WriteColumn(fDoubleColumn.data(), nofRows);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void FluxStore::Close(G4int nofPOT)
+{
+  if (!IsOpen()) return;
+
+  fFile.write(reinterpret_cast<const char*>(fBlocks.data()),
+              fBlocks.size() * sizeof(mirage::FluxBlockInfo));
+  fFile.write(reinterpret_cast<const char*>(fStats.data()),
+              fStats.size() * sizeof(mirage::FluxColumnStats));
+  mirage::FluxFileTrailer trailer{};
+  trailer.indexOffset = fOffset;
+  trailer.nofBlocks = fBlocks.size();
+  trailer.nofRows = fNofRows;
+  std::memcpy(trailer.magic, mirage::kFluxFileMagic, sizeof(trailer.magic));
+  fFile.write(reinterpret_cast<const char*>(&trailer), sizeof(trailer));
+
+  mirage::FluxFileHeader header{};
+  std::memcpy(header.magic, mirage::kFluxFileMagic, sizeof(header.magic));
+  header.version = mirage::kFluxFileVersion;
+  header.byteOrder = mirage::kFluxByteOrder;
+  header.nofColumns = static_cast<std::uint32_t>(fColumns.size());
+  header.nofPOT = nofPOT;
+  fFile.seekp(0);
+  fFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  fFile.close();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void FluxStore::AddColumn(const G4String& name, mirage::FluxColumnType type)
+{
+  mirage::FluxColumnInfo info{};
+  std::strncpy(info.name, name.c_str(), sizeof(info.name) - 1);
+  info.type = type;
+  info.width = mirage::FluxFile::Width(type);
+  fColumns.push_back(info);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+template <class T>
+void FluxStore::WriteColumn(const T* values, std::size_t nofRows)
+{
+  // zone map of the column
+  const auto range = std::minmax_element(values, values + nofRows);
+  fStats.push_back({static_cast<double>(*range.first), static_cast<double>(*range.second)});
+
+  const std::uint64_t size = mirage::FluxFile::ColumnSize(nofRows, sizeof(T));
+  fFile.write(reinterpret_cast<const char*>(values), nofRows * sizeof(T));
+  fFile.write(kPadding, size - nofRows * sizeof(T));
+  fOffset += size;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}  // namespace B1
@@ -0,0 +1,392 @@
+/// \file B1/src/OutputNtuples.cc
+/// \brief Implementation of the B1::OutputNtuples class
+
+#include "OutputNtuples.hh"
+
+#include "LocationWeights.hh"
+#include "OutputBuffer.hh"
+#include "ProjectionPlanes.hh"
+
+#include "G4AccumulableManager.hh"
+#include "G4GenericMessenger.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4Threading.hh"
+
+#include "FluxFile.hh"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <fstream>
+#include <limits>
+
+namespace B1
+{
+
+namespace
+{
+  // momentum and vertex columns of a parent: px, py, pz, E, x, y, z
+  const char* kParentColumns[7] = {"parentPx", "parentPy", "parentPz", "parentE",
+                                   "vertexX", "vertexY", "vertexZ"};
+  const char* kNeutrinoColumns[4] = {"daughterE", "daughterPx", "daughterPy", "daughterPz"};
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+OutputNtuples::OutputNtuples()
+  : fPositionError(0.5 * mm),
+    fMomentumError(0.5 * MeV)
+{
+#if G4VERSION_NUMBER >= 1100
+  G4AccumulableManager::Instance()->Register(fNofNeutrinoRows);
+#else
+  G4AccumulableManager::Instance()->RegisterAccumulable(fNofNeutrinoRows);
+#endif
+
+  DefineCommands();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+OutputNtuples::~OutputNtuples()
+{
+  delete fMessenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void OutputNtuples::Configure(G4AnalysisManager* analysisManager) const
+{
+  if (fCompressionLevel >= 0) analysisManager->SetCompressionLevel(fCompressionLevel);
+  if (fBasketSize > 0) analysisManager->SetBasketSize(fBasketSize);
+#if G4VERSION_NUMBER >= 1100
+  if (fBasketEntries > 0) analysisManager->SetBasketEntries(fBasketEntries);
+#endif
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void OutputNtuples::Book(G4AnalysisManager* analysisManager, ProjectionPlanes& projectionPlanes,
+                         LocationWeights& locationWeights)
+{
+  fAnalysisManager = analysisManager;
+  fParentNtupleId = -1;
+
+  G4int id = -1;
+  if (!fNormalised) {
+    id = analysisManager->CreateNtuple("mirage", "MIRAGE simulation TTree");
+    analysisManager->CreateNtupleIColumn(id, "parentPDG");
+    for (G4int i = 0; i < 7; ++i) CreateColumn(id, kParentColumns[i]);
+  }
+  else {
+    id = analysisManager->CreateNtuple("neutrinos", "MIRAGE neutrinos");
+    analysisManager->CreateNtupleIColumn(id, "event");
+    analysisManager->CreateNtupleIColumn(id, "parent");
+  }
+  analysisManager->CreateNtupleIColumn(id, "daughterPDG");
+  for (const char* name : kNeutrinoColumns) CreateColumn(id, name);
+  analysisManager->CreateNtupleDColumn(id, "weight");
+  projectionPlanes.BookColumns(analysisManager);
+  locationWeights.BookColumns(analysisManager);
+  fExtraColumnNames = projectionPlanes.GetColumnNames();
+  const auto locationNames = locationWeights.GetColumnNames();
+  fExtraColumnNames.insert(fExtraColumnNames.end(), locationNames.begin(), locationNames.end());
+  analysisManager->FinishNtuple(id);
+  fNeutrinoNtupleId = id;
+
+  if (fNormalised) {
+    fParentNtupleId = analysisManager->CreateNtuple("parents", "MIRAGE neutrino parents");
+    analysisManager->CreateNtupleIColumn(fParentNtupleId, "event");
+    analysisManager->CreateNtupleIColumn(fParentNtupleId, "parent");
+    analysisManager->CreateNtupleIColumn(fParentNtupleId, "parentPDG");
+    for (G4int i = 0; i < 7; ++i) CreateColumn(fParentNtupleId, kParentColumns[i]);
+    analysisManager->FinishNtuple(fParentNtupleId);
+  }
+
+  fRunNtupleId = analysisManager->CreateNtuple("runs", "MIRAGE run metadata");
+  analysisManager->CreateNtupleIColumn(fRunNtupleId, "nofPOT");
+  // G4long; a double holds it exactly up to 2^53
+  analysisManager->CreateNtupleDColumn(fRunNtupleId, "seed");
+  analysisManager->CreateNtupleDColumn(fRunNtupleId, "dipoleField");
+  analysisManager->CreateNtupleDColumn(fRunNtupleId, "hornCurrent");
+  analysisManager->CreateNtupleDColumn(fRunNtupleId, "positionStep");
+  analysisManager->CreateNtupleDColumn(fRunNtupleId, "momentumStep");
+  analysisManager->CreateNtupleIColumn(fRunNtupleId, "firstEvent");
+  analysisManager->CreateNtupleIColumn(fRunNtupleId, "lastEvent");
+  analysisManager->FinishNtuple(fRunNtupleId);
+
+  // zone map, only where the rows of a file keep the order they were written
+  fBlockNtupleId = -1;
+  fNofPlaneColumns = projectionPlanes.GetNofColumns();
+  if (IsWritingRoot() && (!fMerging || !G4Threading::IsMultithreadedApplication())) {
+    fBlockNtupleId = analysisManager->CreateNtuple("blocks", "MIRAGE neutrino row blocks");
+    analysisManager->CreateNtupleIColumn(fBlockNtupleId, "firstRow");
+    analysisManager->CreateNtupleIColumn(fBlockNtupleId, "nofRows");
+    analysisManager->CreateNtupleIColumn(fBlockNtupleId, "flavours");
+    std::vector<G4String> names = {"daughterE", "daughterPz"};
+    names.insert(names.end(), fExtraColumnNames.begin(),
+                 fExtraColumnNames.begin() + fNofPlaneColumns);
+    for (auto& name : names) {
+      // minDaughterE, maxDaughterE, ..., minProjXat574m, ...
+      name[0] = static_cast<char>(std::toupper(name[0]));
+      analysisManager->CreateNtupleDColumn(fBlockNtupleId, "min" + name);
+      analysisManager->CreateNtupleDColumn(fBlockNtupleId, "max" + name);
+    }
+    analysisManager->FinishNtuple(fBlockNtupleId);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void OutputNtuples::Write(const OutputBuffer& buffer)
+{
+  fNofNeutrinoRows += static_cast<G4long>(buffer.nofRows);
+  if (!IsWritingRoot()) return;
+
+  if (fNormalised) {
+    for (std::size_t p = 0; p < buffer.nofParents; ++p) {
+      fAnalysisManager->FillNtupleIColumn(fParentNtupleId, 0, buffer.parentEvent[p]);
+      fAnalysisManager->FillNtupleIColumn(fParentNtupleId, 1, buffer.parentIndex[p]);
+      fAnalysisManager->FillNtupleIColumn(fParentNtupleId, 2, buffer.parentPDG[p]);
+      for (G4int i = 0; i < 7; ++i) {
+        FillColumn(fParentNtupleId, 3 + i, buffer.parentValues[i][p], i >= 4);
+      }
+      fAnalysisManager->AddNtupleRow(fParentNtupleId);
+    }
+  }
+
+  const G4int id = fNeutrinoNtupleId;
+  for (std::size_t r = 0; r < buffer.nofRows; ++r) {
+    const std::size_t p = buffer.rowParent[r];
+    G4int column = 0;
+    if (!fNormalised) {
+      fAnalysisManager->FillNtupleIColumn(id, column++, buffer.parentPDG[p]);
+      for (G4int i = 0; i < 7; ++i) {
+        FillColumn(id, column++, buffer.parentValues[i][p], i >= 4);
+      }
+    }
+    else {
+      fAnalysisManager->FillNtupleIColumn(id, column++, buffer.parentEvent[p]);
+      fAnalysisManager->FillNtupleIColumn(id, column++, buffer.parentIndex[p]);
+    }
+    fAnalysisManager->FillNtupleIColumn(id, column++, buffer.rowPDG[r]);
+    FillColumn(id, column++, buffer.rowE[r], false);
+    FillColumn(id, column++, buffer.rowPx[r], false);
+    FillColumn(id, column++, buffer.rowPy[r], false);
+    FillColumn(id, column++, buffer.rowPz[r], false);
+    fAnalysisManager->FillNtupleDColumn(id, column++, buffer.rowWeight[r]);
+
+    // projection planes, then detector locations
+    const G4double* extra = buffer.extra.data() + r * buffer.nofExtraColumns;
+    for (std::size_t j = 0; j < buffer.nofExtraColumns; ++j) {
+      fAnalysisManager->FillNtupleDColumn(id, column++, extra[j]);
+    }
+    fAnalysisManager->AddNtupleRow(id);
+  }
+  if (fBlockNtupleId >= 0) FillBlock(buffer);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void OutputNtuples::FillBlock(const OutputBuffer& buffer)
+{
+  const std::size_t nofRows = buffer.nofRows;
+  if (nofRows == 0) return;
+
+  G4int flavours = 0;
+  for (std::size_t r = 0; r < nofRows; ++r) {
+    flavours |= static_cast<G4int>(mirage::FluxFile::FlavourBit(buffer.rowPDG[r]));
+  }
+
+  const G4int id = fBlockNtupleId;
+  G4int column = 0;
+  fAnalysisManager->FillNtupleIColumn(id, column++, fNofFileRows);
+  fAnalysisManager->FillNtupleIColumn(id, column++, static_cast<G4int>(nofRows));
+  fAnalysisManager->FillNtupleIColumn(id, column++, flavours);
+  for (const auto* values : {&buffer.rowE, &buffer.rowPz}) {
+    const auto range = std::minmax_element(values->begin(), values->begin() + nofRows);
+    fAnalysisManager->FillNtupleDColumn(id, column++, *range.first);
+    fAnalysisManager->FillNtupleDColumn(id, column++, *range.second);
+  }
+  for (std::size_t j = 0; j < fNofPlaneColumns; ++j) {
+    G4double min = buffer.extra[j], max = buffer.extra[j];
+    for (std::size_t r = 1; r < nofRows; ++r) {
+      const G4double value = buffer.extra[r * buffer.nofExtraColumns + j];
+      min = std::min(min, value);
+      max = std::max(max, value);
+    }
+    fAnalysisManager->FillNtupleDColumn(id, column++, min);
+    fAnalysisManager->FillNtupleDColumn(id, column++, max);
+  }
+  fAnalysisManager->AddNtupleRow(id);
+  fNofFileRows += static_cast<G4int>(nofRows);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void OutputNtuples::FillRun(G4int nofPOT, G4long seed, G4double dipoleField,
+                            G4double hornCurrent, G4int firstEvent, G4int lastEvent)
+{
+  const G4bool quantised = (fPrecision == kQuantised);
+  fAnalysisManager->FillNtupleIColumn(fRunNtupleId, 0, nofPOT);
+  fAnalysisManager->FillNtupleDColumn(fRunNtupleId, 1, static_cast<G4double>(seed));
+  fAnalysisManager->FillNtupleDColumn(fRunNtupleId, 2, dipoleField / tesla);
+  fAnalysisManager->FillNtupleDColumn(fRunNtupleId, 3, hornCurrent / ampere);
+  fAnalysisManager->FillNtupleDColumn(fRunNtupleId, 4, quantised ? 2. * fPositionError / m : 0.);
+  fAnalysisManager->FillNtupleDColumn(fRunNtupleId, 5, quantised ? 2. * fMomentumError / GeV : 0.);
+  fAnalysisManager->FillNtupleIColumn(fRunNtupleId, 6, firstEvent);
+  fAnalysisManager->FillNtupleIColumn(fRunNtupleId, 7, lastEvent);
+  fAnalysisManager->AddNtupleRow(fRunNtupleId);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void OutputNtuples::PrintSummary(const std::vector<G4String>& fileNames, G4double runTime,
+                                 G4double writeTime) const
+{
+  G4long bytes = 0;
+  for (const auto& fileName : fileNames) {
+    // the analysis manager adds the extension when there is none
+    std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+    if (!file) file.open(fileName + ".root", std::ios::binary | std::ios::ate);
+    if (file) bytes += static_cast<G4long>(file.tellg());
+  }
+  const G4long nofRows = fNofNeutrinoRows.GetValue();
+
+  static const char* precisions[3] = {"double", "float", "quantised"};
+  G4cout
+    << " Output: " << (fNormalised ? "normalised" : "flat") << ", " << precisions[fPrecision]
+    << ", " << fileNames.size() << (fileNames.size() == 1 ? " file" : " files")
+    << ", compression " << fCompressionLevel << ", basket size " << fBasketSize << G4endl
+    << "   " << nofRows << " neutrino rows, " << bytes << " bytes"
+    << " (" << (nofRows > 0 ? G4double(bytes) / nofRows : 0.) << " bytes/neutrino)" << G4endl
+    << "   " << (runTime > 0. ? bytes / runTime / 1.e6 : 0.) << " MB/s over the run, "
+    << writeTime << " s to write and close" << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void OutputNtuples::CreateColumn(G4int ntupleId, const G4String& name)
+{
+  switch (fPrecision) {
+    case kDouble: fAnalysisManager->CreateNtupleDColumn(ntupleId, name); break;
+    case kFloat: fAnalysisManager->CreateNtupleFColumn(ntupleId, name); break;
+    case kQuantised: fAnalysisManager->CreateNtupleIColumn(ntupleId, name + "Q"); break;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void OutputNtuples::FillColumn(G4int ntupleId, G4int column, G4double value,
+                               G4bool position) const
+{
+  switch (fPrecision) {
+    case kDouble:
+      fAnalysisManager->FillNtupleDColumn(ntupleId, column, value);
+      break;
+    case kFloat:
+      fAnalysisManager->FillNtupleFColumn(ntupleId, column, static_cast<G4float>(value));
+      break;
+    case kQuantised: {
+      // value in m or GeV; rounding to the step of twice the error bound
+      const G4double step = position ? 2. * fPositionError / m : 2. * fMomentumError / GeV;
+      const G4double limit = std::numeric_limits<G4int>::max();
+      const G4double quantum = std::max(-limit, std::min(limit, std::round(value / step)));
+      fAnalysisManager->FillNtupleIColumn(ntupleId, column, static_cast<G4int>(quantum));
+      break;
+    }
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void OutputNtuples::SetSchema(const G4String& schema)
+{
+  fNormalised = (schema == "normalised");
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void OutputNtuples::SetPrecision(const G4String& precision)
+{
+  if (precision == "float") fPrecision = kFloat;
+  else if (precision == "quantised") fPrecision = kQuantised;
+  else fPrecision = kDouble;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void OutputNtuples::DefineCommands()
+{
+  fMessenger = new G4GenericMessenger(this, "/mirage/output/", "Output ntuple control");
+
+  fMessenger->DeclareMethod("schema", &OutputNtuples::SetSchema)
+    .SetGuidance("Layout of the neutrino output.")
+    .SetGuidance("  flat      : mirage ntuple, parent columns on every neutrino row")
+    .SetGuidance("  normalised: parents and neutrinos ntuples linked by (event, parent)")
+    .SetParameterName("schema", false)
+    .SetCandidates("flat normalised")
+    .SetStates(G4State_PreInit, G4State_Idle);
+
+  fMessenger->DeclareProperty("backend", fBackend)
+    .SetGuidance("Where the neutrino rows go:")
+    .SetGuidance("  root: the ntuples of the ROOT file")
+    .SetGuidance("  flux: <name>[_t<N>].flux, fixed-width columns for mirage::FluxReader")
+    .SetGuidance("  both")
+    .SetGuidance("  none: only the histograms (/mirage/histograms/config)")
+    .SetParameterName("backend", false)
+    .SetCandidates("root flux both none")
+    .SetStates(G4State_PreInit, G4State_Idle);
+
+  fMessenger->DeclareProperty("merge", fMerging)
+    .SetGuidance("Merge the rows of the workers into one file at the end of the run.")
+    .SetGuidance("If false, each worker writes <name>_t<N>.root and the master writes")
+    .SetGuidance("<name>.manifest listing them (see analyzer/MirageView.hh).")
+    .SetParameterName("merge", false)
+    .SetStates(G4State_PreInit, G4State_Idle);
+
+  fMessenger->DeclareMethod("precision", &OutputNtuples::SetPrecision)
+    .SetGuidance("Storage of the parent and neutrino momenta, energies and vertices.")
+    .SetGuidance("  double, float, or quantised: int columns <name>Q in steps of twice")
+    .SetGuidance("  the declared error bounds (positionError, momentumError).")
+    .SetParameterName("precision", false)
+    .SetCandidates("double float quantised")
+    .SetStates(G4State_PreInit, G4State_Idle);
+
+  fMessenger->DeclarePropertyWithUnit("positionError", "mm", fPositionError)
+    .SetGuidance("Error bound of the quantised vertex columns.")
+    .SetParameterName("error", false)
+    .SetRange("error>0.")
+    .SetStates(G4State_PreInit, G4State_Idle);
+
+  fMessenger->DeclarePropertyWithUnit("momentumError", "MeV", fMomentumError)
+    .SetGuidance("Error bound of the quantised momentum and energy columns.")
+    .SetParameterName("error", false)
+    .SetRange("error>0.")
+    .SetStates(G4State_PreInit, G4State_Idle);
+
+  fMessenger->DeclareProperty("compression", fCompressionLevel)
+    .SetGuidance("Compression level of the ROOT file (0-9), -1 for the Geant4 default.")
+    .SetGuidance("The Geant4 ROOT writer compresses with zlib only; other algorithms")
+    .SetGuidance("need a recompression afterwards (hadd -f<algorithm><level>).")
+    .SetParameterName("level", false)
+    .SetRange("level>=-1 && level<=9")
+    .SetStates(G4State_PreInit, G4State_Idle);
+
+  fMessenger->DeclareProperty("basketSize", fBasketSize)
+    .SetGuidance("Basket size of the ntuple branches in bytes, 0 for the Geant4 default.")
+    .SetParameterName("bytes", false)
+    .SetRange("bytes>=0")
+    .SetStates(G4State_PreInit, G4State_Idle);
+
+  fMessenger->DeclareProperty("basketEntries", fBasketEntries)
+    .SetGuidance("Entries per basket of the ntuple branches (Geant4 11 and later),")
+    .SetGuidance("0 for the Geant4 default.")
+    .SetParameterName("entries", false)
+    .SetRange("entries>=0")
+    .SetStates(G4State_PreInit, G4State_Idle);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}  // namespace B1
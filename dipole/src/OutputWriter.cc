@@ -0,0 +1,253 @@
+/// \file B1/src/OutputWriter.cc
+/// \brief Implementation of the B1::OutputWriter class
+
+#include "OutputWriter.hh"
+
+#include "FluxStore.hh"
+#include "OutputNtuples.hh"
+
+#include "NumaLayout.hh"
+
+#include "G4GenericMessenger.hh"
+#include "G4ios.hh"
+
+#include <algorithm>
+#include <chrono>
+
+namespace B1
+{
+
+namespace
+{
+  // slots of the queue returning written buffers; buffers allocated beyond
+  // it during a long backlog stay in the pool unused
+  const std::size_t kFreeSlots = 1024;
+
+  G4double SecondsSince(std::chrono::steady_clock::time_point start)
+  {
+    return std::chrono::duration<G4double>(std::chrono::steady_clock::now() - start).count();
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+OutputWriter::OutputWriter()
+{
+  DefineCommands();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+OutputWriter::~OutputWriter()
+{
+  Stop();
+  delete fMessenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void OutputWriter::Start(OutputNtuples* outputNtuples, FluxStore* fluxStore, G4bool inlineOnly)
+{
+  fOutputNtuples = outputNtuples;
+  fFluxStore = fluxStore;
+  fNofExtraColumns = outputNtuples->GetNofExtraColumns();
+  fThreaded = fAsync && !inlineOnly;
+  fNofBuffers = 0;
+  fNofRows = 0;
+  fBacklogPeak = 0;
+  fWriteTime = 0.;
+  fDrainTime = 0.;
+
+  // the buffers of the previous run are reused, at the current row layout
+  const std::size_t nofBuffers = fThreaded ? fQueueDepth + 2 : 1;
+  while (fPool.size() < nofBuffers) {
+    fPool.emplace_back(new OutputBuffer(0, 0));
+  }
+  for (auto& buffer : fPool) {
+    buffer->Resize(fBufferRows, fNofExtraColumns);
+  }
+
+  fCurrent = fPool[0].get();
+  fBacklog.clear();
+  fRunning = true;
+  if (!fThreaded) return;
+
+  fFull.reset(new mirage::SpscQueue<OutputBuffer*>(fQueueDepth));
+  fFree.reset(new mirage::SpscQueue<OutputBuffer*>(kFreeSlots));
+  for (std::size_t i = 1; i < fPool.size(); ++i) {
+    fFree->Push(fPool[i].get());
+  }
+  fStopping.store(false);
+  fNofWritten.store(0);
+  fThread = std::thread(&OutputWriter::WriteBuffers, this);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void OutputWriter::Stop()
+{
+  if (!fRunning) return;
+
+  const auto start = std::chrono::steady_clock::now();
+  Flush();
+  fRunning = false;
+  if (fThreaded) {
+    fStopping.store(true, std::memory_order_release);
+    fThread.join();
+  }
+  fDrainTime = SecondsSince(start);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void OutputWriter::Flush()
+{
+  if (!fRunning) return;
+
+  if (fCurrent->nofRows > 0) Submit();
+  if (!fThreaded) return;
+
+  // the tracking waits here, so waiting for room in the queue is fine
+  while (!fBacklog.empty()) {
+    if (fFull->Push(fBacklog.front())) fBacklog.pop_front();
+    else std::this_thread::yield();
+  }
+  while (fNofWritten.load(std::memory_order_acquire) < fNofBuffers) {
+    std::this_thread::yield();
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+OutputBuffer* OutputWriter::Reserve(std::size_t nofRows)
+{
+  if (!fCurrent->HasRoom(nofRows) && fCurrent->nofRows > 0) Submit();
+  // a decay with more neutrinos than a buffer holds
+  if (!fCurrent->HasRoom(nofRows)) fCurrent->Resize(nofRows, fNofExtraColumns);
+  return fCurrent;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void OutputWriter::Submit()
+{
+  ++fNofBuffers;
+  fNofRows += fCurrent->nofRows;
+
+  if (!fThreaded) {
+    Write(*fCurrent);
+    fCurrent->Clear();
+    return;
+  }
+
+  // keep the order of the buffers: the backlog goes first
+  fBacklog.push_back(fCurrent);
+  while (!fBacklog.empty() && fFull->Push(fBacklog.front())) {
+    fBacklog.pop_front();
+  }
+  fBacklogPeak = std::max(fBacklogPeak, fBacklog.size());
+  fCurrent = TakeFreeBuffer();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void OutputWriter::Write(const OutputBuffer& buffer)
+{
+  const auto start = std::chrono::steady_clock::now();
+  fOutputNtuples->Write(buffer);
+  if (fOutputNtuples->IsWritingFlux()) fFluxStore->Write(buffer);
+  fWriteTime += SecondsSince(start);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+OutputBuffer* OutputWriter::TakeFreeBuffer()
+{
+  OutputBuffer* buffer = nullptr;
+  if (fFree->Pop(buffer)) return buffer;
+
+  // the writer is behind: allocate rather than wait
+  fPool.emplace_back(new OutputBuffer(fBufferRows, fNofExtraColumns));
+  return fPool.back().get();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void OutputWriter::WriteBuffers()
+{
+  // near the buffers of its worker when the workers are pinned (--pin)
+  mirage::NumaLayout::PinToLocalNode();
+
+  OutputBuffer* buffer = nullptr;
+  while (true) {
+    if (fFull->Pop(buffer)) {
+      Write(*buffer);
+      buffer->Clear();
+      fFree->Push(buffer);
+      fNofWritten.fetch_add(1, std::memory_order_release);
+      continue;
+    }
+    // Stop() submits everything before setting fStopping
+    if (fStopping.load(std::memory_order_acquire)) {
+      if (fFull->IsEmpty()) return;
+      continue;
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void OutputWriter::PrintSummary(G4double runTime) const
+{
+  if (fNofBuffers == 0) return;
+
+  G4cout
+    << " Output writer: " << (fThreaded ? "asynchronous" : "inline") << ", "
+    << fNofRows << " rows in " << fNofBuffers << " buffers" << G4endl;
+  if (!fThreaded) {
+    G4cout
+      << "   " << fWriteTime << " s writing on the tracking thread ("
+      << (runTime > 0. ? 100. * fWriteTime / runTime : 0.) << "% of the run)" << G4endl;
+    return;
+  }
+
+  // what the writer did before the end of the run ran alongside tracking
+  const G4double overlapped = std::max(0., fWriteTime - fDrainTime);
+  G4cout
+    << "   writer busy " << fWriteTime << " s, " << overlapped << " s overlapped with tracking ("
+    << (fWriteTime > 0. ? 100. * overlapped / fWriteTime : 100.) << "%), "
+    << fDrainTime << " s draining at the end of the run" << G4endl
+    << "   backlog peak " << fBacklogPeak << " buffers, " << fPool.size()
+    << " buffers allocated" << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void OutputWriter::DefineCommands()
+{
+  fMessenger = new G4GenericMessenger(this, "/mirage/output/writer/", "Output writer control");
+
+  fMessenger->DeclareProperty("async", fAsync)
+    .SetGuidance("Fill the ntuples on a writer thread of each worker instead of the")
+    .SetGuidance("tracking thread. Inline when the culled ntuple is booked.")
+    .SetParameterName("async", false)
+    .SetStates(G4State_PreInit, G4State_Idle);
+
+  fMessenger->DeclareProperty("bufferRows", fBufferRows)
+    .SetGuidance("Neutrino rows per output buffer.")
+    .SetParameterName("rows", false)
+    .SetRange("rows>0")
+    .SetStates(G4State_PreInit, G4State_Idle);
+
+  fMessenger->DeclareProperty("queueDepth", fQueueDepth)
+    .SetGuidance("Full buffers that can wait for the writer thread before the")
+    .SetGuidance("tracking thread keeps them in a local backlog.")
+    .SetParameterName("buffers", false)
+    .SetRange("buffers>0")
+    .SetStates(G4State_PreInit, G4State_Idle);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}  // namespace B1
@@ -29,7 +29,10 @@
 
 #include "PrimaryGeneratorAction.hh"
 
+#include "EventSeeds.hh"
+
 #include "G4Box.hh"
+#include "G4Event.hh"
 #include "G4LogicalVolume.hh"
 #include "G4LogicalVolumeStore.hh"
 #include "G4ParticleGun.hh"
@@ -42,7 +45,8 @@ namespace B1
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-PrimaryGeneratorAction::PrimaryGeneratorAction()
+PrimaryGeneratorAction::PrimaryGeneratorAction(const EventSeeds* eventSeeds)
+  : fEventSeeds(eventSeeds)
 {
   G4int n_particle = 1;
   fParticleGun = new G4ParticleGun(n_particle);
@@ -67,6 +71,9 @@ PrimaryGeneratorAction::~PrimaryGeneratorAction()
 
 void PrimaryGeneratorAction::GeneratePrimaries(G4Event* event)
 {
+  // before anything of the event draws a number
+  if (fEventSeeds->IsEnabled()) fEventSeeds->Reseed(event->GetEventID());
+
   fParticleGun->SetParticlePosition(G4ThreeVector(0,0,-300.0*m));
 
   fParticleGun->GeneratePrimaryVertex(event);
@@ -0,0 +1,172 @@
+/// \file B1/src/RunManifest.cc
+/// \brief Implementation of the B1::RunManifest class
+
+#include "RunManifest.hh"
+
+#include "G4AutoLock.hh"
+#include "G4Threading.hh"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+namespace B1
+{
+
+namespace
+{
+  G4Mutex manifestMutex = G4MUTEX_INITIALIZER;
+
+  // output name without the extension the analysis manager adds
+  G4String BaseName(const G4String& outputName)
+  {
+    G4String base = outputName;
+    if (base.size() > 5 && base.compare(base.size() - 5, 5, ".root") == 0) {
+      base.erase(base.size() - 5);
+    }
+    return base;
+  }
+
+  // file name relative to the directory of the manifest
+  G4String LocalName(const G4String& fileName)
+  {
+    const std::size_t slash = fileName.find_last_of('/');
+    return slash == std::string::npos ? fileName : G4String(fileName.substr(slash + 1));
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4String RunManifest::GetPartName(const G4String& outputName)
+{
+  // the naming of the per-thread files of the Geant4 analysis manager
+  if (!G4Threading::IsWorkerThread()) return BaseName(outputName) + ".root";
+  return BaseName(outputName) + "_t" + std::to_string(G4Threading::G4GetThreadId()) + ".root";
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4String RunManifest::GetProcessName(const G4String& outputName)
+{
+  if (GetProcess() < 0) return outputName;
+  return BaseName(outputName) + "_p" + std::to_string(GetProcess()) + ".root";
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunManifest::AddPart(const G4String& partName, G4int nofPOT, G4long nofRows,
+                          G4int firstEvent, G4int lastEvent)
+{
+  G4AutoLock lock(&manifestMutex);
+  // a forked process is sequential; its parts are numbered by the process
+  const G4int thread = GetProcess() >= 0 ? GetProcess() : G4Threading::G4GetThreadId();
+  GetParts().push_back({GetPartName(partName), thread, nofPOT, nofRows, firstEvent, lastEvent});
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+std::vector<G4String> RunManifest::Write(const G4String& outputName, const G4String& schema,
+                                         G4long seed, G4int nofPOT, G4bool masterFile)
+{
+  G4AutoLock lock(&manifestMutex);
+  std::vector<Part> parts;
+  parts.swap(GetParts());
+  // the parts of a thread stay in the order they were closed
+  std::stable_sort(parts.begin(), parts.end(),
+                   [](const Part& a, const Part& b) { return a.thread < b.thread; });
+
+  std::vector<G4String> fileNames;
+  for (const auto& part : parts) fileNames.push_back(part.fileName);
+
+  const G4String fileName = BaseName(outputName) + ".manifest";
+  std::ofstream file(fileName);
+  if (!file) {
+    G4ExceptionDescription msg;
+    msg << "Cannot write the run manifest " << fileName << ".";
+    G4Exception("RunManifest::Write()", "MIRAGE010", JustWarning, msg);
+    return fileNames;
+  }
+
+  file << "# mirage run manifest" << '\n'
+       << "schema " << schema << '\n'
+       << "seed " << seed << '\n'
+       << "pot " << nofPOT << '\n';
+  if (masterFile) file << "runs " << LocalName(BaseName(outputName) + ".root") << '\n';
+  for (const auto& part : parts) {
+    file << "part " << LocalName(part.fileName) << ' ' << part.thread << ' ' << part.nofPOT
+         << ' ' << part.nofRows << ' ' << part.firstEvent << ' ' << part.lastEvent << '\n';
+  }
+  return fileNames;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4long RunManifest::MergeProcesses(const G4String& outputName, G4int nofProcesses,
+                                   G4long seed)
+{
+  G4String schema = "flat";
+  G4long nofPOT = 0;
+  std::vector<std::string> partLines;
+  for (G4int process = 0; process < nofProcesses; ++process) {
+    const G4String fileName = BaseName(outputName) + "_p" + std::to_string(process) + ".manifest";
+    std::ifstream file(fileName);
+    if (!file) {
+      G4ExceptionDescription msg;
+      msg << "No manifest " << fileName << " of process " << process << "; its output is"
+          << " not in the manifest of the job.";
+      G4Exception("RunManifest::MergeProcesses()", "MIRAGE010", JustWarning, msg);
+      continue;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+      std::istringstream words(line);
+      std::string key;
+      words >> key;
+      if (key == "schema") words >> schema;
+      else if (key == "pot") {
+        G4long pot = 0;
+        words >> pot;
+        nofPOT += pot;
+      }
+      else if (key == "part") partLines.push_back(line);
+    }
+    file.close();
+    std::remove(fileName.c_str());
+  }
+
+  const G4String fileName = BaseName(outputName) + ".manifest";
+  std::ofstream file(fileName);
+  if (!file) {
+    G4ExceptionDescription msg;
+    msg << "Cannot write the run manifest " << fileName << ".";
+    G4Exception("RunManifest::MergeProcesses()", "MIRAGE010", JustWarning, msg);
+    return nofPOT;
+  }
+  file << "# mirage run manifest" << '\n'
+       << "schema " << schema << '\n'
+       << "seed " << seed << '\n'
+       << "pot " << nofPOT << '\n';
+  for (const auto& line : partLines) file << line << '\n';
+  return nofPOT;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+std::vector<RunManifest::Part>& RunManifest::GetParts()
+{
+  static std::vector<Part> parts;
+  return parts;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int& RunManifest::GetProcessIndex()
+{
+  static G4int process = -1;
+  return process;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}  // namespace B1
@@ -0,0 +1,37 @@
+/// \file B1/src/SpecialCutsPhysics.cc
+/// \brief Implementation of the B1::SpecialCutsPhysics class
+
+#include "SpecialCutsPhysics.hh"
+
+#include "G4ParticleDefinition.hh"
+#include "G4ProcessManager.hh"
+#include "G4UserSpecialCuts.hh"
+
+namespace B1
+{
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+SpecialCutsPhysics::SpecialCutsPhysics(const G4String& name)
+  : G4VPhysicsConstructor(name)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void SpecialCutsPhysics::ConstructProcess()
+{
+  auto userSpecialCuts = new G4UserSpecialCuts();
+
+  auto particleIterator = GetParticleIterator();
+  particleIterator->reset();
+  while ((*particleIterator)()) {
+    G4ParticleDefinition* particle = particleIterator->value();
+    if (particle->IsShortLived()) continue;
+    G4ProcessManager* processManager = particle->GetProcessManager();
+    if (processManager) processManager->AddDiscreteProcess(userSpecialCuts);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}  // namespace B1
@@ -0,0 +1,200 @@
+#ifndef MirageView_h
+#define MirageView_h
+
+#include "ROOT/RDataFrame.hxx"
+#include "TChain.h"
+#include "TEntryList.h"
+#include "TFile.h"
+#include "TTree.h"
+#include "TTreeFormula.h"
+
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Flat view of a mirage output file for the analysis macros.
+//
+// Files written with /mirage/output/schema normalised hold a "neutrinos"
+// and a "parents" tree linked by (event, parent) instead of the flat
+// "mirage" tree. The view attaches the parents to the neutrinos as an
+// indexed friend, so that parentPDG, parentPx, ..., vertexZ read as if they
+// were columns of the neutrino rows. Files written with
+// /mirage/output/precision quantised hold int columns <name>Q; the data
+// frame of the view decodes them under their usual names with the steps of
+// the "runs" tree.
+//   MirageView view("output.root");
+//   auto df = view.GetDataFrame();
+// Flat, unquantised files give their "mirage" tree unchanged.
+//
+// A <name>.manifest, written with /mirage/output/merge false or
+// /mirage/output/roll, is opened as one dataset: the trees of its parts
+// (the files of the workers, or the rolled files) are chained, and the
+// steps come from the "runs" tree of the master file or of the first part.
+//   MirageView view("output.manifest");
+//
+// Files with the rows of one thread carry a "blocks" tree, the zone map of
+// the neutrino rows (see OutputNtuples). SelectBlocks() restricts the view,
+// before GetDataFrame(), to the blocks whose ranges and flavours can pass a
+// selection on the "blocks" columns, and the others are never read:
+//   view.SelectBlocks("(flavours & 4) && maxDaughterPz > 0"
+//                     " && minProjXat574m < 3.5 && maxProjXat574m > -3.5");
+// The flavour bits are 1 numu, 2 numubar, 4 nue, 8 nuebar. The rows of
+// the selected blocks still go through the filters of the analysis.
+class MirageView
+{
+public:
+    explicit MirageView(const std::string& fileName)
+    {
+        const std::string extension = ".manifest";
+        if (fileName.size() > extension.size() &&
+            fileName.compare(fileName.size() - extension.size(), extension.size(), extension) == 0) {
+            OpenManifest(fileName);
+            return;
+        }
+
+        fFile.reset(TFile::Open(fileName.c_str()));
+        if (!fFile || fFile->IsZombie()) return;
+        fFileNames.push_back(fileName);
+        fTree = fFile->Get<TTree>("mirage");
+        if (!fTree) {
+            fTree = fFile->Get<TTree>("neutrinos");
+            auto parents = fFile->Get<TTree>("parents");
+            if (!fTree || !parents) {
+                fTree = nullptr;
+                return;
+            }
+            parents->BuildIndex("event", "parent");
+            fTree->AddFriend(parents);
+        }
+        ReadSteps(fFile->Get<TTree>("runs"));
+    }
+
+    // nullptr if the file is not a mirage output file
+    TTree* GetTree() const { return fTree; }
+    bool IsNormalised() const { return fTree && fTree->GetFriend("parents"); }
+
+    // Keeps the blocks of rows for which the expression on the "blocks"
+    // tree is true; false, and no selection, if a file has no zone map
+    bool SelectBlocks(const std::string& selection)
+    {
+        if (!fTree) return false;
+        auto list = std::make_unique<TEntryList>("blocks", selection.c_str());
+        Long64_t offset = 0;  // of the file in the chain
+        Long64_t nofBlocks = 0, nofSelected = 0;
+        for (const auto& fileName : fFileNames) {
+            std::unique_ptr<TFile> file(TFile::Open(fileName.c_str()));
+            TTree* blocks = file && !file->IsZombie() ? file->Get<TTree>("blocks") : nullptr;
+            TTree* rows = blocks ? file->Get<TTree>(fTree->GetName()) : nullptr;
+            if (!rows) return false;
+
+            Int_t firstRow = 0, nofRows = 0;
+            blocks->SetBranchAddress("firstRow", &firstRow);
+            blocks->SetBranchAddress("nofRows", &nofRows);
+            TTreeFormula formula("selection", selection.c_str(), blocks);
+            if (formula.GetNdim() == 0) return false;
+            for (Long64_t b = 0; b < blocks->GetEntries(); ++b) {
+                blocks->GetEntry(b);
+                formula.GetNdata();
+                ++nofBlocks;
+                if (formula.EvalInstance() == 0.) continue;
+                ++nofSelected;
+                for (Long64_t r = firstRow; r < firstRow + nofRows; ++r) {
+                    list->Enter(offset + r, fTree);
+                }
+            }
+            offset += rows->GetEntries();
+        }
+        std::cout << "MirageView: " << nofSelected << " of " << nofBlocks << " blocks, "
+                  << list->GetN() << " of " << offset << " rows selected" << std::endl;
+        fTree->SetEntryList(list.get());
+        fEntryList = std::move(list);
+        return true;
+    }
+
+    // data frame over GetTree() with the quantised columns decoded
+    ROOT::RDF::RNode GetDataFrame()
+    {
+        fDataFrame = std::make_unique<ROOT::RDataFrame>(*fTree);
+        ROOT::RDF::RNode node = *fDataFrame;
+        const char* positions[] = {"vertexX", "vertexY", "vertexZ"};
+        const char* momenta[] = {"parentPx", "parentPy", "parentPz", "parentE",
+                                 "daughterE", "daughterPx", "daughterPy", "daughterPz"};
+        for (const char* name : positions) node = Decode(node, name, fPositionStep);
+        for (const char* name : momenta) node = Decode(node, name, fMomentumStep);
+        return node;
+    }
+
+private:
+    void OpenManifest(const std::string& fileName)
+    {
+        // part and runs files are relative to the manifest
+        const std::string directory = fileName.substr(0, fileName.find_last_of('/') + 1);
+        std::ifstream manifest(fileName);
+        std::vector<std::string> parts;
+        std::string line, key, name, runsName;
+        while (std::getline(manifest, line)) {
+            std::istringstream is(line);
+            if (!(is >> key >> name)) continue;
+            if (key == "runs") runsName = directory + name;
+            else if (key == "part") parts.push_back(directory + name);
+        }
+        if (parts.empty()) return;
+
+        std::unique_ptr<TFile> first(TFile::Open(parts.front().c_str()));
+        if (!first || first->IsZombie()) return;
+        const bool normalised = !first->Get<TTree>("mirage") && first->Get<TTree>("parents");
+        fChain = std::make_unique<TChain>(normalised ? "neutrinos" : "mirage");
+        for (const auto& part : parts) fChain->Add(part.c_str());
+        fFileNames = parts;
+        fTree = fChain.get();
+        if (normalised) {
+            // the event numbers of the workers interleave, so ROOT indexes
+            // the parents over the whole chain instead of per file
+            fParents = std::make_unique<TChain>("parents");
+            for (const auto& part : parts) fParents->Add(part.c_str());
+            fParents->BuildIndex("event", "parent");
+            fTree->AddFriend(fParents.get());
+        }
+
+        fFile.reset(TFile::Open((runsName.empty() ? parts.front() : runsName).c_str()));
+        if (fFile && !fFile->IsZombie()) ReadSteps(fFile->Get<TTree>("runs"));
+    }
+
+    void ReadSteps(TTree* runs)
+    {
+        if (!runs || !runs->GetBranch("positionStep")) return;
+        runs->SetBranchAddress("positionStep", &fPositionStep);
+        runs->SetBranchAddress("momentumStep", &fMomentumStep);
+        runs->GetEntry(0);
+        runs->ResetBranchAddresses();
+    }
+
+    static ROOT::RDF::RNode Decode(ROOT::RDF::RNode node, const std::string& name, double step)
+    {
+        if (step <= 0. || node.HasColumn(name)) return node;
+        std::ostringstream expression;
+        expression.precision(17);
+        for (const std::string& quantised : {name + "Q", "parents." + name + "Q"}) {
+            if (node.HasColumn(quantised)) {
+                expression << quantised << " * " << step;
+                return node.Define(name, expression.str());
+            }
+        }
+        return node;
+    }
+
+    std::vector<std::string> fFileNames;  // of the rows, in the order of the chain
+    std::unique_ptr<TEntryList> fEntryList;
+    std::unique_ptr<TFile> fFile;
+    std::unique_ptr<TChain> fParents;  // friend of fChain, destroyed after it
+    std::unique_ptr<TChain> fChain;
+    TTree* fTree = nullptr;
+    std::unique_ptr<ROOT::RDataFrame> fDataFrame;
+    double fPositionStep = 0.;
+    double fMomentumStep = 0.;
+};
+
+#endif
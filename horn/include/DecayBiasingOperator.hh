@@ -0,0 +1,74 @@
+/// \file mirage_horn/include/DecayBiasingOperator.hh
+/// \brief Definition of the mirage_horn::DecayBiasingOperator class
+
+#ifndef mirage_hornDecayBiasingOperator_h
+#define mirage_hornDecayBiasingOperator_h 1
+
+#include "G4VBiasingOperator.hh"
+#include "globals.hh"
+
+#include <map>
+#include <vector>
+
+class G4BOptnChangeCrossSection;
+class G4GenericMessenger;
+
+namespace mirage_horn
+{
+
+/// Decay biasing for the neutrino parents.
+///
+/// Occurrence biasing of the wrapped "Decay" process (G4GenericBiasingPhysics,
+/// enabled with --bias-decay): for the selected species the decay point is
+/// sampled from an exponential of mean min(gamma*beta*c*tau, decayLength)
+/// instead of the analog one, so most parents decay within the decay region.
+/// The framework carries the importance weight: the parent weight is
+/// multiplied by the survival probability ratio along each step and the decay
+/// products by the interaction weight, so each neutrino row is written with
+/// its track weight.
+///
+/// Attached to the world volume in DetectorConstruction::ConstructSDandField,
+/// one instance per worker. Controlled by /mirage/biasing/ (after
+/// /run/initialize).
+
+class DecayBiasingOperator : public G4VBiasingOperator
+{
+  public:
+    DecayBiasingOperator();
+    ~DecayBiasingOperator() override;
+
+    void StartRun() override;
+
+  private:
+    G4VBiasingOperation* ProposeOccurenceBiasingOperation(
+      const G4Track* track, const G4BiasingProcessInterface* callingProcess) override;
+    G4VBiasingOperation* ProposeFinalStateBiasingOperation(
+      const G4Track*, const G4BiasingProcessInterface*) override { return nullptr; }
+    G4VBiasingOperation* ProposeNonPhysicsBiasingOperation(
+      const G4Track*, const G4BiasingProcessInterface*) override { return nullptr; }
+
+    using G4VBiasingOperator::OperationApplied;
+    void OperationApplied(const G4BiasingProcessInterface* callingProcess,
+                          G4BiasingAppliedCase biasingCase,
+                          G4VBiasingOperation* occurenceOperationApplied,
+                          G4double weightForOccurenceInteraction,
+                          G4VBiasingOperation* finalStateOperationApplied,
+                          const G4VParticleChange* particleChangeProduced) override;
+
+    G4bool IsSelected(G4int pdg) const;
+    void SetSpecies(const G4String& pdgList);
+    void DefineCommands();
+
+    G4GenericMessenger* fMessenger = nullptr;
+    std::map<const G4BiasingProcessInterface*, G4BOptnChangeCrossSection*> fOperations;
+
+    G4bool fEnabled = true;
+    G4double fDecayLength = 0.;
+    std::vector<G4int> fSpecies;
+};
+
+}  // namespace mirage_horn
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,60 @@
+/// \file mirage_horn/include/DecayMultiplexer.hh
+/// \brief Definition of the mirage_horn::DecayMultiplexer class
+
+#ifndef mirage_hornDecayMultiplexer_h
+#define mirage_hornDecayMultiplexer_h 1
+
+#include "DecayKinematics.hh"
+
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+
+class G4GenericMessenger;
+
+namespace mirage_horn
+{
+
+/// Decay multiplexing: for every pi+-, K+-, K0L or mu+- decay SteppingAction
+/// records, K more decays of the same parent are sampled analytically
+/// (mirage::DecayKinematics) and written next to the one Geant4 made. Each
+/// of the K+1 decays then carries 1/(K+1) of the parent weight, so the flux
+/// normalisation is unchanged while the statistics per simulated parent grow
+/// by K+1. The mode is drawn from the branching ratios, as Geant4 does.
+///
+/// One instance per worker (owned by SteppingAction); K is set with
+/// /mirage/multiplex/nofDecays (after /run/initialize), 0 switches it off.
+
+class DecayMultiplexer
+{
+  public:
+    DecayMultiplexer();
+    ~DecayMultiplexer();
+
+    G4int GetNofDecays() const { return fNofDecays; }
+
+    /// True if the decays of \p parentPDG are multiplexed
+    G4bool Applies(G4int parentPDG) const
+    {
+      return fNofDecays > 0 && mirage::DecayKinematics::CanDecay(parentPDG);
+    }
+
+    /// Neutrinos of K decays of the parent (GeV, laboratory frame);
+    /// valid until the next call
+    const mirage::DecayKinematics::NeutrinoBatch& Sample(G4int parentPDG,
+                                                         const G4ThreeVector& parentMom);
+
+  private:
+    void DefineCommands();
+
+    G4GenericMessenger* fMessenger = nullptr;
+    G4int fNofDecays = 0;
+
+    mirage::DecayKinematics::Sampler fSampler;
+    mirage::DecayKinematics::NeutrinoBatch fBatch;
+};
+
+}  // namespace mirage_horn
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -4,16 +4,33 @@
 #include "G4VUserDetectorConstruction.hh"
 #include "globals.hh"
 
+#include <vector>
+
 class G4VPhysicalVolume;
 class G4LogicalVolume;
-class G4FieldManager;
-class SimpleHornMagneticField;
+class G4GenericMessenger;
+class G4Region;
+
+/**
+ * @brief 자기장 영역의 z 범위와 적분 자기장(B*L)의 상한
+ *
+ * 하전 입자가 이 영역에서 받을 수 있는 최대 횡운동량은 c_light * maxBL 입니다.
+ * (AcceptanceFilter에서 사용)
+ */
+struct FieldRegionBound
+{
+  G4double zMin;
+  G4double zMax;
+  G4double maxBL;
+};
 
 /**
  * @brief Geant4 지오메트리를 정의하는 메인 클래스
  *
  * 이 클래스는 월드 볼륨과 단순화된 마그네틱 혼 지오메트리를 생성합니다.
- * 또한 SimpleHornMagneticField를 생성하여 적절한 볼륨에 할당합니다.
+ * SimpleHornMagneticField와 field manager는 stepper, chord finder와 함께
+ * ConstructSDandField()에서 스레드마다 따로 생성하여 혼의 자기장 영역에 할당합니다
+ * (멀티스레드 실행에서 공유하지 않음).
  */
 class DetectorConstruction : public G4VUserDetectorConstruction
 {
@@ -23,25 +40,43 @@ public:
 
   // Geant4가 호출하는 지오메트리 생성 함수
   virtual G4VPhysicalVolume* Construct();
+  // 스레드별 자기장 생성과 decay biasing operator 부착
+  virtual void ConstructSDandField();
 
-  SimpleHornMagneticField* GetHornAMagneticField() { return fMagFieldA; }
-  SimpleHornMagneticField* GetHornBMagneticField() { return fMagFieldB; }
-  SimpleHornMagneticField* GetHornCMagneticField() { return fMagFieldC; }
+  G4bool IsEnvelopeEnabled() const { return fEnvelope; }
+
+  const std::vector<FieldRegionBound>& GetFieldRegionBounds() const { return fFieldRegionBounds; }
+  // 혼 전류 (run 메타데이터용)
+  G4double GetHornCurrent() const;
+  // --bias-decay: 물리 리스트에 G4GenericBiasingPhysics가 있어야 함
+  void SetDecayBiasing(G4bool val) { fDecayBiasing = val; }
 
 private:
   // Helper functions
   void ConstructWorld(G4VPhysicalVolume*& physWorld);
+  void ConstructEnvelope(G4LogicalVolume* logicWorld);
+  G4Region* CreateRegion(const G4String& name);
+  void SetRegionMinEkine(const G4String& args);
+  void DefineCommands();
   void ConstructHornA(G4LogicalVolume* logicWorld);
   void ConstructHornB(G4LogicalVolume* logicWorld);
   void ConstructHornC(G4LogicalVolume* logicWorld);
 
-  // 자기장 멤버 변수
-  SimpleHornMagneticField* fMagFieldA;
-  SimpleHornMagneticField* fMagFieldB;
-  SimpleHornMagneticField* fMagFieldC;
-  G4FieldManager* fFieldMgrA;
-  G4FieldManager* fFieldMgrB;
-  G4FieldManager* fFieldMgrC;
+  // 혼의 자기장 영역과 전류: Construct()에서 기록, ConstructSDandField()에서 사용
+  struct Magnet
+  {
+    G4LogicalVolume* volume;
+    G4double current;
+  };
+  std::vector<Magnet> fMagnets;
+  std::vector<FieldRegionBound> fFieldRegionBounds;
+
+  // 빔라인 envelope (kill 볼륨) 설정, /mirage/geometry/
+  G4GenericMessenger* fMessenger;
+  G4bool fEnvelope;
+  G4double fDecayPipeRadius;
+  G4double fAbsorberZ;
+  G4bool fDecayBiasing;
 
   // 볼륨 멤버 변수 (필요시 사용)
   G4LogicalVolume* logicInnerCondA;
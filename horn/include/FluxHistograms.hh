@@ -0,0 +1,96 @@
+/// \file mirage_horn/include/FluxHistograms.hh
+/// \brief Definition of the mirage_horn::FluxHistograms class
+
+#ifndef mirage_hornFluxHistograms_h
+#define mirage_hornFluxHistograms_h 1
+
+#include "G4Version.hh"
+#if G4VERSION_NUMBER >= 1100
+  #include "G4AnalysisManager.hh"
+#else
+  #include "g4root.hh"
+#endif
+#include "globals.hh"
+
+#include <vector>
+
+class G4GenericMessenger;
+
+namespace mirage_horn
+{
+
+/// Flux histograms filled during the simulation, the ones analyzer/
+/// mirage_plot.C makes from the ntuple, so that a production scan needs no
+/// analysis pass (with /mirage/output/backend none, no ntuple either).
+///
+/// The histograms are read from a configuration file with
+/// /mirage/histograms/config, one per line (see macros/flux_histograms.cfg):
+///
+///   h1 <name> <flavour> <selection> <x> <bins> <min> <max>
+///   h2 <name> <flavour> <selection> <x> <bins> <min> <max> <y> <bins> <min> <max>
+///
+/// with flavour all, numu, numubar, nue or nuebar, selection all, forward
+/// (daughterPz > 0) or ff (forward and in mirage::FluxWindow on the at574m
+/// plane), and x, y any of daughterE, daughterPx, daughterPy, daughterPz
+/// and the plane and location columns of the ntuple, in its units (GeV, m).
+/// Every row is filled with its weight.
+///
+/// The histograms are booked through the analysis manager, filled by each
+/// thread from SteppingAction and merged with the other histograms at the
+/// end of the run. Owned by RunAction.
+
+class FluxHistograms
+{
+  public:
+    FluxHistograms();
+    ~FluxHistograms();
+
+    /// Books the configured histograms; \p columnNames are the plane and
+    /// location columns of a row (OutputNtuples::GetExtraColumnNames())
+    void Book(G4AnalysisManager* analysisManager, const std::vector<G4String>& columnNames);
+
+    /// Fills the histograms with one neutrino row (GeV, columns as in
+    /// OutputBuffer::AddNeutrino())
+    void Fill(G4AnalysisManager* analysisManager, G4int pdg, G4double E, G4double px,
+              G4double py, G4double pz, G4double weight, const G4double* columns) const;
+
+  private:
+    enum Selection { kAll, kForward, kWindow };
+
+    struct Config
+    {
+      G4String name;
+      G4int dimension;
+      G4int pdg;  // 0 for all flavours
+      Selection selection;
+      G4String x, y;
+      G4int nofBinsX, nofBinsY;
+      G4double minX, maxX, minY, maxY;
+    };
+
+    struct Histogram
+    {
+      G4int id;
+      G4int dimension;
+      G4int pdg;
+      Selection selection;
+      G4int x, y;  // indices of the values of a row, see Fill()
+    };
+
+    void ReadConfig(const G4String& fileName);
+    void ClearConfigs();
+    void DefineCommands();
+
+    G4GenericMessenger* fMessenger = nullptr;
+    std::vector<Config> fConfigs;
+
+    std::vector<Histogram> fHistograms;
+    G4int fWindowX = -1;  // columns of the at574m plane
+    G4int fWindowY = -1;
+};
+
+}  // namespace mirage_horn
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,67 @@
+/// \file mirage_horn/include/FluxStore.hh
+/// \brief Definition of the mirage_horn::FluxStore class
+
+#ifndef mirage_hornFluxStore_h
+#define mirage_hornFluxStore_h 1
+
+#include "FluxFile.hh"
+
+#include "globals.hh"
+
+#include <cstdint>
+#include <fstream>
+#include <vector>
+
+namespace mirage_horn
+{
+
+struct OutputBuffer;
+
+/// Writer of the columnar flux files (mirage::FluxReader, tools/fluxscan):
+/// the neutrino rows of the flat ntuple, with the plane and location
+/// columns, as fixed-width column blocks, one block per OutputBuffer, with
+/// the range of every column and the flavours of every block as zone map.
+///
+/// One file per output part, <part>.flux next to <part>.root. Owned by
+/// RunAction, which opens and closes it with the parts; OutputWriter writes
+/// the buffers. Enabled with /mirage/output/backend flux or both.
+
+class FluxStore
+{
+  public:
+    FluxStore() = default;
+    ~FluxStore();
+
+    G4bool IsOpen() const { return fFile.is_open(); }
+
+    /// Opens the file of the part \p partName (as given to the analysis
+    /// manager) of this thread, with the columns \p extraNames after the
+    /// neutrino columns
+    void Open(const G4String& partName, const std::vector<G4String>& extraNames);
+    /// Writes the rows of \p buffer as one block
+    void Write(const OutputBuffer& buffer);
+    /// Writes the block index, the zone map and the header
+    void Close(G4int nofPOT);
+
+  private:
+    void AddColumn(const G4String& name, mirage::FluxColumnType type);
+    template <class T>
+    void WriteColumn(const T* values, std::size_t nofRows);
+
+    std::ofstream fFile;
+    std::vector<mirage::FluxColumnInfo> fColumns;
+    std::vector<mirage::FluxBlockInfo> fBlocks;
+    std::vector<mirage::FluxColumnStats> fStats;  // block-major
+    std::uint64_t fOffset = 0;
+    std::uint64_t fNofRows = 0;
+
+    // parent and location values gathered per row
+    std::vector<std::int32_t> fIntColumn;
+    std::vector<double> fDoubleColumn;
+};
+
+}  // namespace mirage_horn
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,84 @@
+/// \file mirage_horn/include/LocationWeights.hh
+/// \brief Definition of the mirage_horn::LocationWeights class
+
+#ifndef mirage_hornLocationWeights_h
+#define mirage_hornLocationWeights_h 1
+
+#include "G4ThreeVector.hh"
+#include "G4Version.hh"
+#if G4VERSION_NUMBER >= 1100
+  #include "G4AnalysisManager.hh"
+#else
+  #include "g4root.hh"
+#endif
+#include "globals.hh"
+
+#include <vector>
+
+class G4GenericMessenger;
+
+namespace mirage_horn
+{
+
+/// Location weights of every recorded neutrino for a list of detector
+/// points (mirage::LocationWeight): the probability per m^2 that the
+/// neutrino points at the location, and its energy there. Every decay then
+/// contributes to every location instead of only the neutrinos that happen
+/// to cross a window.
+///
+/// For each location <name> the mirage ntuple gets the columns
+/// <name>Weight (m^-2) and <name>E (GeV), and optionally the histograms
+/// <name>_numu, <name>_numubar, <name>_nue and <name>_nuebar of the energy
+/// at the location, weighted with weight x location weight.
+///
+/// Locations are given with /mirage/locations/add before the run, with x
+/// and y in the world frame and z as the distance from the upstream face of
+/// the world, like the 574 m projection plane. Owned by RunAction, which
+/// books the columns; filled from SteppingAction.
+
+class LocationWeights
+{
+  public:
+    LocationWeights();
+    ~LocationWeights();
+
+    G4bool IsEmpty() const { return fLocations.empty(); }
+
+    /// Books the columns of the current ntuple (before FinishNtuple)
+    void BookColumns(G4AnalysisManager* analysisManager) const;
+    std::size_t GetNofColumns() const { return 2 * fLocations.size(); }
+    /// Names of the columns, in the order of Fill()
+    std::vector<G4String> GetColumnNames() const;
+    /// Books the histograms and places the locations in the world frame
+    void Book(G4AnalysisManager* analysisManager, G4double worldHalfZ);
+
+    /// Computes the columns of one neutrino row into \p columns and fills
+    /// the histograms
+    void Fill(G4AnalysisManager* analysisManager, G4double* columns,
+              const G4ThreeVector& parentMom, G4double parentE, const G4ThreeVector& decayPos,
+              G4int nuPDG, const G4ThreeVector& nuMom, G4double nuE, G4double weight) const;
+
+  private:
+    struct Location
+    {
+      G4String name;
+      G4double x, y, distance;  // m
+      G4double z;               // m, world frame, set by Book()
+    };
+
+    void AddLocation(const G4String& args);
+    void ClearLocations();
+    void DefineCommands();
+
+    G4GenericMessenger* fMessenger = nullptr;
+    std::vector<Location> fLocations;
+    G4bool fHistograms = false;
+
+    G4int fFirstH1 = -1;
+};
+
+}  // namespace mirage_horn
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,151 @@
+/// \file mirage_horn/include/OutputNtuples.hh
+/// \brief Definition of the mirage_horn::OutputNtuples class
+
+#ifndef mirage_hornOutputNtuples_h
+#define mirage_hornOutputNtuples_h 1
+
+#include "G4Accumulable.hh"
+#include "G4Version.hh"
+#if G4VERSION_NUMBER >= 1100
+  #include "G4AnalysisManager.hh"
+#else
+  #include "g4root.hh"
+#endif
+#include "globals.hh"
+
+#include <cstddef>
+#include <vector>
+
+class G4GenericMessenger;
+
+namespace mirage_horn
+{
+
+class LocationWeights;
+struct OutputBuffer;
+class ProjectionPlanes;
+
+/// Layout of the neutrino output, chosen with /mirage/output/schema:
+///
+/// - flat (default): the "mirage" ntuple, one row per neutrino with the
+///   parent columns repeated on every row.
+/// - normalised: a "parents" ntuple with one row per decay (event, parent,
+///   parentPDG, parentPx/Py/Pz, parentE, vertexX/Y/Z) and a "neutrinos"
+///   ntuple (event, parent, daughterPDG, daughterE, daughterPx/Py/Pz,
+///   weight, planes, locations) linked to it by (event, parent), where
+///   parent counts the decays of the event. analyzer/MirageView.hh joins
+///   them back into the flat layout.
+///
+/// Both write a "runs" ntuple with one row per run, or per part of the
+/// run in the file (OutputParts): nofPOT, seed (double), dipoleField (T),
+/// hornCurrent (A), positionStep (m), momentumStep (GeV), and firstEvent
+/// and lastEvent, the range of event IDs covered.
+///
+/// /mirage/output/precision sets the storage of the parent and neutrino
+/// momenta, energies and vertices: double (default), float, or quantised
+/// to int columns <name>Q in steps of twice the declared error bounds
+/// (/mirage/output/positionError, momentumError), so that the rounding
+/// error is at most the bound; the steps go to the runs ntuple and
+/// MirageView decodes the columns back under their usual names. The
+/// weight, plane and location columns stay double. Compression level and
+/// basket size of the ROOT file are set with /mirage/output/compression and
+/// basketSize (and basketEntries, Geant4 11).
+///
+/// With /mirage/output/merge false the workers write their own files
+/// instead of sending their rows to the master at the end of the run, and
+/// the master lists them in a manifest (RunManifest). /mirage/output/backend
+/// sends the neutrino rows to the ROOT file (root), to a columnar flux file
+/// (flux, see FluxStore), to both, or nowhere (none, when the flux
+/// histograms are all that is needed, see FluxHistograms); the ROOT file
+/// always has the run ntuple and the histograms.
+///
+/// Files with the rows of one thread (sequential mode, or without merging)
+/// also get a "blocks" ntuple, the zone map of the neutrino rows: one row
+/// per OutputBuffer with firstRow and nofRows (entries of the neutrino
+/// ntuple in this file), flavours (mirage::FluxFlavour bits: 1 numu,
+/// 2 numubar, 4 nue, 8 nuebar), and the range of daughterE, daughterPz and
+/// the plane columns (minDaughterE, maxDaughterE, ..., minProjXat574m,
+/// maxProjXat574m, ...). MirageView::
+/// SelectBlocks() reads only the blocks that can pass a selection. Merged
+/// files interleave the rows of the workers and have no zone map.
+///
+/// The neutrino ntuple is always the first one, so that ProjectionPlanes and
+/// LocationWeights book their columns of it without an ntuple id. Owned by
+/// RunAction; filled by OutputWriter from the buffered rows.
+
+class OutputNtuples
+{
+  public:
+    OutputNtuples();
+    ~OutputNtuples();
+
+    G4bool IsNormalised() const { return fNormalised; }
+    G4bool IsMerging() const { return fMerging; }
+    /// Neutrino rows to the ROOT file, to the flux file (FluxStore), both
+    /// or neither
+    G4bool IsWritingRoot() const { return fBackend == "root" || fBackend == "both"; }
+    G4bool IsWritingFlux() const { return fBackend == "flux" || fBackend == "both"; }
+    /// Neutrino rows of this thread, or of the run on the master after the merge
+    G4long GetNofNeutrinoRows() const { return fNofNeutrinoRows.GetValue(); }
+
+    /// Applies the file settings (before OpenFile)
+    void Configure(G4AnalysisManager* analysisManager) const;
+    /// Books the neutrino (and parent) ntuples, with the plane and location
+    /// columns, and the run ntuple
+    void Book(G4AnalysisManager* analysisManager, ProjectionPlanes& projectionPlanes,
+              LocationWeights& locationWeights);
+
+    /// Starts the row count of the zone map of a newly opened file
+    void BeginFile() { fNofFileRows = 0; }
+
+    /// Plane and location columns of a neutrino row (after Book())
+    std::size_t GetNofExtraColumns() const { return fExtraColumnNames.size(); }
+    const std::vector<G4String>& GetExtraColumnNames() const { return fExtraColumnNames; }
+
+    /// Fills the parent and neutrino rows of \p buffer; called by OutputWriter
+    void Write(const OutputBuffer& buffer);
+    void FillRun(G4int nofPOT, G4long seed, G4double dipoleField, G4double hornCurrent,
+                 G4int firstEvent, G4int lastEvent);
+
+    /// Size of the closed output files per neutrino row (after the
+    /// accumulables are merged)
+    void PrintSummary(const std::vector<G4String>& fileNames, G4double runTime,
+                      G4double writeTime) const;
+
+  private:
+    enum Precision { kDouble, kFloat, kQuantised };
+
+    void CreateColumn(G4int ntupleId, const G4String& name);
+    void FillColumn(G4int ntupleId, G4int column, G4double value, G4bool position) const;
+    void FillBlock(const OutputBuffer& buffer);
+    void SetSchema(const G4String& schema);
+    void SetPrecision(const G4String& precision);
+    void DefineCommands();
+
+    G4GenericMessenger* fMessenger = nullptr;
+    G4bool fNormalised = false;
+    G4bool fMerging = true;
+    G4String fBackend = "root";
+    Precision fPrecision = kDouble;
+    G4double fPositionError = 0.;
+    G4double fMomentumError = 0.;
+    G4int fCompressionLevel = -1;  // Geant4 default
+    G4int fBasketSize = 0;
+    G4int fBasketEntries = 0;
+
+    G4AnalysisManager* fAnalysisManager = nullptr;
+    G4int fNeutrinoNtupleId = -1;
+    G4int fParentNtupleId = -1;
+    G4int fRunNtupleId = -1;
+    G4int fBlockNtupleId = -1;
+    std::size_t fNofPlaneColumns = 0;
+    G4int fNofFileRows = 0;
+    std::vector<G4String> fExtraColumnNames;
+    G4Accumulable<G4long> fNofNeutrinoRows{G4long(0)};
+};
+
+}  // namespace mirage_horn
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,44 @@
+/// \file mirage_horn/include/PhysicsListFactory.hh
+/// \brief Definition of the mirage_horn::PhysicsListFactory class
+
+#ifndef mirage_hornPhysicsListFactory_h
+#define mirage_hornPhysicsListFactory_h 1
+
+#include "G4VModularPhysicsList.hh"
+#include "globals.hh"
+
+namespace mirage_horn
+{
+
+/// Builds the physics list of one of the beamline tiers, selected on the
+/// command line with --physics=<tier>:
+///
+/// - full: FTFP_BERT as is (the default, and the reference for the others).
+/// - flux: keeps hadronic inelastic physics and decay, which make the
+///   neutrino flux. EM physics is replaced by G4EmStandardPhysics_option1
+///   (faster e-/e+/gamma, same hadron and muon energy loss), photo- and
+///   electro-nuclear physics (G4EmExtraPhysics) is removed, and neutrons are
+///   killed below 100 MeV instead of being followed down to thermal energies.
+/// - fast: flux, minus hadron elastic scattering, nuclear capture at rest
+///   (G4StoppingPhysics) and ion physics, with neutrons killed below 500 MeV.
+///   Hadron elastic scattering in the target widens the parent angular
+///   spread, so expect a visible change of the flux shape.
+///
+/// Every tier also gets SpecialCutsPhysics for the region user limits.
+/// With --bias-decay the decay of pi+-, K+- and K0L is wrapped by
+/// G4GenericBiasingPhysics for DecayBiasingOperator.
+/// scripts/bench_physics.sh measures the throughput and flux-shape deltas of
+/// the tiers against full.
+
+class PhysicsListFactory
+{
+  public:
+    /// Returns a new physics list; aborts (MIRAGE006) on an unknown tier
+    static G4VModularPhysicsList* Create(const G4String& tier, G4bool biasDecay = false);
+};
+
+}  // namespace mirage_horn
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
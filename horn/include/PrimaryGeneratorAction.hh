@@ -39,6 +39,8 @@ class G4Box;
 namespace mirage_horn
 {
 
+class EventSeeds;
+
 /// The primary generator action class with particle gun.
 ///
 /// The default kinematic is a 6 MeV gamma, randomly distribued
@@ -47,7 +49,7 @@ namespace mirage_horn
 class PrimaryGeneratorAction : public G4VUserPrimaryGeneratorAction
 {
   public:
-    PrimaryGeneratorAction();
+    PrimaryGeneratorAction(const EventSeeds* eventSeeds);
     ~PrimaryGeneratorAction() override;
 
     // method from the base class
@@ -59,6 +61,7 @@ class PrimaryGeneratorAction : public G4VUserPrimaryGeneratorAction
   private:
     G4ParticleGun* fParticleGun = nullptr;  // pointer a to G4 gun class
     G4Box* fEnvelopeBox = nullptr;
+    const EventSeeds* fEventSeeds = nullptr;
 };
 
 }  // namespace mirage_horn
@@ -0,0 +1,84 @@
+/// \file mirage_horn/include/ProjectionPlanes.hh
+/// \brief Definition of the mirage_horn::ProjectionPlanes class
+
+#ifndef mirage_hornProjectionPlanes_h
+#define mirage_hornProjectionPlanes_h 1
+
+#include "PlaneProjection.hh"
+
+#include "G4ThreeVector.hh"
+#include "G4Version.hh"
+#if G4VERSION_NUMBER >= 1100
+  #include "G4AnalysisManager.hh"
+#else
+  #include "g4root.hh"
+#endif
+#include "globals.hh"
+
+#include <vector>
+
+class G4GenericMessenger;
+
+namespace mirage_horn
+{
+
+/// Projections of every recorded neutrino onto a list of planes
+/// (mirage::PlaneProjection), computed for all the neutrinos of a decay at
+/// once.
+///
+/// For each plane <name> the mirage ntuple gets the columns projX<name> and
+/// projY<name> (m, in the plane, relative to its centre; -9999 for neutrinos
+/// going away from the plane). The default plane "at574m", normal to the
+/// beam at 574 m, gives the projXat574m and projYat574m columns.
+///
+/// Planes are given with /mirage/planes/add before the run, with x and y in
+/// the world frame and z as the distance from the upstream face of the
+/// world, like the detector locations. Owned by RunAction, which books the
+/// columns; filled from SteppingAction into the OutputBuffer rows.
+
+class ProjectionPlanes
+{
+  public:
+    ProjectionPlanes();
+    ~ProjectionPlanes();
+
+    /// Books the columns of the current ntuple (before FinishNtuple)
+    void BookColumns(G4AnalysisManager* analysisManager) const;
+    std::size_t GetNofColumns() const { return 2 * fConfigs.size(); }
+    /// Names of the columns, in the order of Fill()
+    std::vector<G4String> GetColumnNames() const;
+    /// Places the planes in the world frame
+    void Build(G4double worldHalfZ);
+
+    /// Projects the \p n neutrinos of momenta (px, py, pz), in GeV, of the
+    /// decay at \p decayPos onto every plane
+    void Project(const G4ThreeVector& decayPos, const G4double* px, const G4double* py,
+                 const G4double* pz, std::size_t n);
+    /// Copies the columns of neutrino \p i of the last Project() to \p columns
+    void Fill(G4double* columns, std::size_t i) const;
+
+  private:
+    struct PlaneConfig
+    {
+      G4String name;
+      G4double x, y, distance;  // m
+      G4double nx, ny, nz;      // normal
+    };
+
+    void AddPlane(const G4String& args);
+    void ClearPlanes();
+    void DefineCommands();
+
+    G4GenericMessenger* fMessenger = nullptr;
+    std::vector<PlaneConfig> fConfigs;
+    std::vector<mirage::PlaneProjection::Plane> fPlanes;  // world frame, set by Build()
+
+    std::vector<G4double> fProjections;
+    std::size_t fNofProjected = 0;
+};
+
+}  // namespace mirage_horn
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -36,11 +36,43 @@
 #include "G4Accumulable.hh"
 #include "globals.hh"
 
+#include "AcceptanceFilter.hh"
+#include "ConvergenceMonitor.hh"
+#include "EventSeeds.hh"
+#include "FluxHistograms.hh"
+#include "FluxStore.hh"
+#include "LocationWeights.hh"
+#include "OutputNtuples.hh"
+#include "OutputParts.hh"
+#include "OutputWriter.hh"
+#include "ParentStore.hh"
+#include "ProjectionPlanes.hh"
+#include "SteppingContext.hh"
+
+#include "G4Timer.hh"
+
+#include <vector>
+
+class G4GenericMessenger;
 class G4Run;
 
 namespace mirage_horn
 {
 
+/// Categories of tracks killed by StackingAction
+enum KillCategory
+{
+  kKilledNeutrino = 0,
+  kKilledEm,
+  kKilledMuon,
+  kKilledNeutron,
+  kKilledIon,
+  kKilledHadron,
+  kKilledSpecies,
+  kKilledAcceptance,
+  kNofKillCategories
+};
+
 /// Run action class
 ///
 /// In EndOfRunAction(), it calculates the dose in the selected volume
@@ -51,13 +83,53 @@ class RunAction : public G4UserRunAction
 {
   public:
     RunAction(G4String fileName);
-    ~RunAction() override = default;
+    ~RunAction() override;
 
     void BeginOfRunAction(const G4Run*) override;
     void EndOfRunAction(const G4Run*) override;
 
+    const SteppingContext* GetSteppingContext() const { return &fSteppingContext; }
+    const AcceptanceFilter* GetAcceptanceFilter() const { return &fAcceptanceFilter; }
+    ParentStore* GetParentStore() { return &fParentStore; }
+    const LocationWeights* GetLocationWeights() const { return &fLocationWeights; }
+    ProjectionPlanes* GetProjectionPlanes() { return &fProjectionPlanes; }
+    const FluxHistograms* GetFluxHistograms() const { return &fFluxHistograms; }
+    ConvergenceMonitor* GetConvergenceMonitor() { return &fConvergenceMonitor; }
+    EventSeeds* GetEventSeeds() { return &fEventSeeds; }
+    OutputNtuples* GetOutputNtuples() { return &fOutputNtuples; }
+    OutputWriter* GetOutputWriter() { return &fOutputWriter; }
+
+    void CountKilledTrack(KillCategory category) { fNofKilled[category] += 1; }
+    /// Ends the run when the flux has converged, and rolls the output over
+    /// to the next part when the current one is full
+    void EndOfEvent(G4int eventID);
+
   private:
-    G4String fOutputName;
+    void PrintKillSummary(G4int nofEvents) const;
+    void FillRunRow(G4int nofPOT, G4int firstEvent, G4int lastEvent);
+    void ClosePart();
+
+    G4String fFileName;    // of the command line
+    G4String fOutputName;  // of the process (--fork)
+    SteppingContext fSteppingContext;
+    AcceptanceFilter fAcceptanceFilter;
+    ParentStore fParentStore;
+    LocationWeights fLocationWeights;
+    ProjectionPlanes fProjectionPlanes;
+    FluxHistograms fFluxHistograms;
+    ConvergenceMonitor fConvergenceMonitor;
+    EventSeeds fEventSeeds;
+    OutputNtuples fOutputNtuples;
+    OutputWriter fOutputWriter;
+    FluxStore fFluxStore;
+    OutputParts fOutputParts;
+
+    std::vector<G4Accumulable<G4long>> fNofKilled;
+    G4Timer fTimer;
+    G4long fSeed = 0;
+
+    G4GenericMessenger* fMessenger = nullptr;
+    G4int fBenchmarkIterations = 0;
 };
 
 }  // namespace mirage_horn
@@ -15,6 +15,8 @@ public:
   virtual void GetFieldValue(const G4double Point[4], // [x,y,z,t]
                              G4double* Bfield) const; // [Bx,By,Bz]
 
+  G4double GetCurrent() const { return fCurrent; }
+
 private:
   G4double fCurrent; // 피크 전류 (Ampere)
   G4double fMu0;     // 진공 투자율 (mu_0)
@@ -0,0 +1,59 @@
+/// \file mirage_horn/include/StackingAction.hh
+/// \brief Definition of the mirage_horn::StackingAction class
+
+#ifndef mirage_hornStackingAction_h
+#define mirage_hornStackingAction_h 1
+
+#include "G4UserStackingAction.hh"
+#include "globals.hh"
+
+class G4GenericMessenger;
+class G4Track;
+
+namespace mirage_horn
+{
+
+class RunAction;
+
+/// Stacking action class
+///
+/// Culls tracks that cannot change the recorded neutrino flux before
+/// Geant4 transports them:
+/// - neutrinos, which SteppingAction has already recorded at the decay step;
+/// - tracks below a per-species kinetic energy threshold;
+/// - optionally every species other than pi+-, K+-, K0L and mu+-;
+/// - optionally pi+-, K+- and K0L whose neutrinos cannot reach the
+///   near-detector window (see AcceptanceFilter, /mirage/acceptance/).
+/// Primaries are never killed. Kills are counted per category in RunAction.
+/// Controlled through the /mirage/stack/ commands.
+
+class StackingAction : public G4UserStackingAction
+{
+  public:
+    StackingAction(RunAction* runAction);
+    ~StackingAction() override;
+
+    G4ClassificationOfNewTrack ClassifyNewTrack(const G4Track* track) override;
+
+  private:
+    void DefineCommands();
+
+    RunAction* fRunAction = nullptr;
+    G4GenericMessenger* fMessenger = nullptr;
+
+    G4bool fKillNeutrinos = true;
+    G4bool fOnlyNeutrinoParents = false;
+
+    // kinetic energy thresholds, 0 = keep everything
+    G4double fEmThreshold = 0.;
+    G4double fMuonThreshold = 0.;
+    G4double fNeutronThreshold = 0.;
+    G4double fIonThreshold = 0.;
+    G4double fHadronThreshold = 0.;
+};
+
+}  // namespace mirage_horn
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,76 @@
+/// \file mirage_horn/include/SteppingContext.hh
+/// \brief Definition of the mirage_horn::SteppingContext class
+
+#ifndef mirage_hornSteppingContext_h
+#define mirage_hornSteppingContext_h 1
+
+#include "globals.hh"
+
+#include "G4Version.hh"
+#if G4VERSION_NUMBER >= 1100
+  #include "G4AnalysisManager.hh"
+#else
+  #include "g4root.hh"
+#endif
+
+#include <cstdint>
+
+class G4VProcess;
+
+namespace mirage_horn
+{
+
+/// Per-worker cache of everything SteppingAction needs on every step.
+///
+/// Build() is called once per run from RunAction::BeginOfRunAction(), on the
+/// thread that will use it. After that the per-step checks are pointer and
+/// integer compares only: no singleton lookups, no navigator walk, no string
+/// comparison and no allocation.
+
+class SteppingContext
+{
+  public:
+    SteppingContext() = default;
+    ~SteppingContext() = default;
+
+    void Build();
+
+    /// True if \p process is one of the decay processes of this thread
+    G4bool IsDecay(const G4VProcess* process) const
+    {
+      for (G4int i = 0; i < fNofDecayProcesses; ++i) {
+        if (process == fDecayProcesses[i]) return true;
+      }
+      return false;
+    }
+
+    /// True for nu_e, nu_mu, nu_tau and their antiparticles
+    static G4bool IsNeutrino(G4int pdg)
+    {
+      const std::uint32_t absPDG = pdg < 0 ? -pdg : pdg;
+      return absPDG < 32 && ((kNeutrinoMask >> absPDG) & 1u);
+    }
+
+    G4bool IsBuilt() const { return fAnalysisManager != nullptr; }
+    G4AnalysisManager* GetAnalysisManager() const { return fAnalysisManager; }
+    G4double GetWorldHalfZ() const { return fWorldHalfZ; }
+    G4double GetProjectionPlaneZ() const { return fProjectionPlaneZ; }
+    G4int GetNofDecayProcesses() const { return fNofDecayProcesses; }
+
+    static constexpr G4int kMaxDecayProcesses = 16;
+
+  private:
+    static constexpr std::uint32_t kNeutrinoMask = (1u << 12) | (1u << 14) | (1u << 16);
+
+    G4AnalysisManager* fAnalysisManager = nullptr;
+    const G4VProcess* fDecayProcesses[kMaxDecayProcesses] = {};
+    G4int fNofDecayProcesses = 0;
+    G4double fWorldHalfZ = 0.;
+    G4double fProjectionPlaneZ = 0.;
+};
+
+}  // namespace mirage_horn
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,30 @@
+#!/bin/bash
+
+# This script compares the events per second of the flux region cuts
+# (macros/cuts_flux.mac) with the uniform default cuts.
+# Run it from the build directory:
+#   ./scripts/bench_cuts.sh [horn current [A]] [seed]
+
+EXE=./mirage_horn
+ARG=${1:-3000}
+SEED=${2:-1234}
+MACRO_FILE=macros/bench_cuts.mac
+
+for CUTS in uniform flux; do
+    echo "Running with cuts_$CUTS.mac ..."
+    MIRAGE_CUTS=macros/cuts_$CUTS.mac $EXE $MACRO_FILE $ARG $SEED bench_cuts_$CUTS.root > bench_cuts_$CUTS.log 2>&1
+    if [ $? -ne 0 ]; then
+        echo "Error: $EXE failed, see bench_cuts_$CUTS.log"
+        exit 1
+    fi
+done
+
+# the global run summary is printed last
+MS_UNIFORM=$(sed -n 's/.*(\([0-9.e+-]*\) ms\/POT).*/\1/p' bench_cuts_uniform.log | tail -n 1)
+MS_FLUX=$(sed -n 's/.*(\([0-9.e+-]*\) ms\/POT).*/\1/p' bench_cuts_flux.log | tail -n 1)
+
+awk -v a="$MS_UNIFORM" -v b="$MS_FLUX" 'BEGIN {
+    printf "uniform cuts: %10.2f POT/s\n", 1000. / a
+    printf "flux cuts   : %10.2f POT/s\n", 1000. / b
+    printf "speed-up    : %.2fx\n", a / b
+}'
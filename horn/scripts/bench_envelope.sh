@@ -0,0 +1,28 @@
+#!/bin/bash
+
+# This script measures the throughput gain of the beamline envelope
+# (/mirage/geometry/envelope) against the open-world geometry.
+# Run it from the build directory:
+#   ./scripts/bench_envelope.sh [horn current [A]] [seed]
+
+EXE=./mirage_horn
+ARG=${1:-3000}
+SEED=${2:-1234}
+MACRO_FILE=macros/bench_envelope.mac
+
+for ENVELOPE in false true; do
+    echo "Running with envelope=$ENVELOPE ..."
+    MIRAGE_ENVELOPE=$ENVELOPE $EXE $MACRO_FILE $ARG $SEED bench_envelope_$ENVELOPE.root > bench_envelope_$ENVELOPE.log 2>&1
+    if [ $? -ne 0 ]; then
+        echo "Error: $EXE failed, see bench_envelope_$ENVELOPE.log"
+        exit 1
+    fi
+done
+
+# the global run summary is printed last
+MS_OPEN=$(sed -n 's/.*(\([0-9.e+-]*\) ms\/POT).*/\1/p' bench_envelope_false.log | tail -n 1)
+MS_ENVELOPE=$(sed -n 's/.*(\([0-9.e+-]*\) ms\/POT).*/\1/p' bench_envelope_true.log | tail -n 1)
+
+echo "open world: $MS_OPEN ms/POT"
+echo "envelope  : $MS_ENVELOPE ms/POT"
+awk -v a="$MS_OPEN" -v b="$MS_ENVELOPE" 'BEGIN { printf "throughput gain: %.2fx\n", a / b }'
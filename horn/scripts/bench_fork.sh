@@ -0,0 +1,69 @@
+#!/bin/bash
+
+# This script compares the forked runner (--fork=N: one initialisation, N
+# processes sharing the physics tables copy-on-write) with N independent
+# processes that each build their own, for the same POT: wall time,
+# events/s and memory. The memory of the forked job is its aggregate peak
+# PSS (shared pages counted once), that of the independent processes the
+# sum of their peak RSS (GNU time).
+# Run it from the build directory:
+#   ./scripts/bench_fork.sh [horn current [A]] [seed] [POT] [processes]
+
+EXE=./mirage_horn
+ARG=${1:-3000}
+SEED=${2:-1234}
+POT=${3:-10000}
+NOF_PROCESSES=${4:-$(nproc)}
+MACRO_FILE=macros/bench_threads.mac
+TIME_CMD=/usr/bin/time
+
+now() { date +%s.%N; }
+
+NAME=bench_fork
+echo "Running with --fork=$NOF_PROCESSES ..."
+START=$(now)
+MIRAGE_POT=$POT $EXE --fork=$NOF_PROCESSES $MACRO_FILE $ARG $SEED $NAME.root > $NAME.log 2>&1
+if [ $? -ne 0 ]; then
+    echo "Error: $EXE failed, see $NAME.log"
+    exit 1
+fi
+FORK_TIME=$(awk -v s="$START" -v e="$(now)" 'BEGIN { print e - s }')
+FORK_INIT=$(sed -n 's/.*initialisation: \([0-9.]*\) s.*/\1/p' $NAME.log | tail -n 1)
+FORK_MEMORY=$(sed -n 's/.*aggregate peak PSS.*: \([0-9.]*\) MB.*/\1/p' $NAME.log | tail -n 1)
+
+echo "Running $NOF_PROCESSES independent processes ..."
+START=$(now)
+PIDS=""
+for (( I = 0; I < NOF_PROCESSES; ++I )); do
+    NAME=bench_fork_single_$I
+    # the events of the forked job, split the same way
+    SHARE=$(( (I + 1) * POT / NOF_PROCESSES - I * POT / NOF_PROCESSES ))
+    if [ -x $TIME_CMD ]; then
+        MIRAGE_POT=$SHARE $TIME_CMD -f "%M" -o $NAME.rss \
+            $EXE $MACRO_FILE $ARG $(( SEED + I )) $NAME.root > $NAME.log 2>&1 &
+    else
+        MIRAGE_POT=$SHARE $EXE $MACRO_FILE $ARG $(( SEED + I )) $NAME.root > $NAME.log 2>&1 &
+    fi
+    PIDS="$PIDS $!"
+done
+for PID in $PIDS; do
+    if ! wait $PID; then
+        echo "Error: $EXE failed, see bench_fork_single_*.log"
+        exit 1
+    fi
+done
+SINGLE_TIME=$(awk -v s="$START" -v e="$(now)" 'BEGIN { print e - s }')
+SINGLE_MEMORY=$(cat bench_fork_single_*.rss 2>/dev/null | awk '{ kB += $NF } END { if (NR) printf "%.1f", kB / 1024 }')
+
+printf "%-13s %10s %12s %12s\n" mode time[s] events/s memory[MB]
+for MODE in fork independent; do
+    if [ $MODE = fork ]; then
+        TIME=$FORK_TIME; MEMORY=$FORK_MEMORY
+    else
+        TIME=$SINGLE_TIME; MEMORY=$SINGLE_MEMORY
+    fi
+    awk -v m="$MODE" -v n="$POT" -v t="$TIME" -v mem="${MEMORY:-n/a}" 'BEGIN {
+        printf "%-13s %10.2f %12.2f %12s\n", m, t, (t > 0 ? n / t : 0), mem
+    }'
+done
+echo "(the forked job initialised once, in ${FORK_INIT:-?} s)"
@@ -0,0 +1,32 @@
+#!/bin/bash
+
+# This script measures the cost of decay multiplexing: the time per POT
+# with K = 0, 10 and 100 extra analytic decays per pi/K decay.
+# Each multiplexed run holds about K+1 times the neutrino rows.
+# Run it from the build directory:
+#   ./scripts/bench_multiplex.sh [horn current [A]] [seed]
+
+EXE=./mirage_horn
+ARG=${1:-3000}
+SEED=${2:-1234}
+MACRO_FILE=macros/bench_multiplex.mac
+
+for K in 0 10 100; do
+    echo "Running with /mirage/multiplex/nofDecays $K ..."
+    MIRAGE_MULTIPLEX=$K $EXE $MACRO_FILE $ARG $SEED bench_multiplex_$K.root > bench_multiplex_$K.log 2>&1
+    if [ $? -ne 0 ]; then
+        echo "Error: $EXE failed, see bench_multiplex_$K.log"
+        exit 1
+    fi
+done
+
+# the global run summary is printed last
+MS_0=$(sed -n 's/.*(\([0-9.e+-]*\) ms\/POT).*/\1/p' bench_multiplex_0.log | tail -n 1)
+MS_10=$(sed -n 's/.*(\([0-9.e+-]*\) ms\/POT).*/\1/p' bench_multiplex_10.log | tail -n 1)
+MS_100=$(sed -n 's/.*(\([0-9.e+-]*\) ms\/POT).*/\1/p' bench_multiplex_100.log | tail -n 1)
+
+awk -v a="$MS_0" -v b="$MS_10" -v c="$MS_100" 'BEGIN {
+    printf "K =   0: %10.3f ms/POT\n", a
+    printf "K =  10: %10.3f ms/POT  (x%.2f time, x11 decays)\n", b, b / a
+    printf "K = 100: %10.3f ms/POT  (x%.2f time, x101 decays)\n", c, c / a
+}'
@@ -0,0 +1,53 @@
+#!/bin/bash
+
+# This script measures the size and the write throughput of the output for
+# the column precisions (double, float, quantised) and compression levels.
+# If hadd is found, the double file is also recompressed with LZ4 and ZSTD,
+# which the Geant4 ROOT writer cannot write itself.
+# Run it from the build directory:
+#   ./scripts/bench_output.sh [horn current [A]] [seed]
+
+EXE=./mirage_horn
+ARG=${1:-3000}
+SEED=${2:-1234}
+MACRO_FILE=macros/bench_output.mac
+
+SETTINGS="double:1 float:1 quantised:1 double:9 quantised:9"
+
+for SETTING in $SETTINGS; do
+    PRECISION=${SETTING%:*}
+    LEVEL=${SETTING#*:}
+    NAME=bench_output_${PRECISION}_${LEVEL}
+    echo "Running with /mirage/output/precision $PRECISION, compression $LEVEL ..."
+    MIRAGE_PRECISION=$PRECISION MIRAGE_COMPRESSION=$LEVEL $EXE $MACRO_FILE $ARG $SEED $NAME.root > $NAME.log 2>&1
+    if [ $? -ne 0 ]; then
+        echo "Error: $EXE failed, see $NAME.log"
+        exit 1
+    fi
+done
+
+# the output summary of the global run is printed last
+printf "%-10s %5s %12s %16s %10s\n" precision level bytes bytes/neutrino MB/s
+for SETTING in $SETTINGS; do
+    PRECISION=${SETTING%:*}
+    LEVEL=${SETTING#*:}
+    NAME=bench_output_${PRECISION}_${LEVEL}
+    ROWS=$(sed -n 's/^ *\([0-9]*\) neutrino rows.*/\1/p' $NAME.log | tail -n 1)
+    BYTES=$(sed -n 's/.* neutrino rows, \([0-9.e+]*\) bytes.*/\1/p' $NAME.log | tail -n 1)
+    RATE=$(sed -n 's/^ *\([0-9.e+-]*\) MB\/s over the run.*/\1/p' $NAME.log | tail -n 1)
+    awk -v p="$PRECISION" -v l="$LEVEL" -v b="$BYTES" -v n="$ROWS" -v r="$RATE" 'BEGIN {
+        printf "%-10s %5s %12d %16.2f %10.3f\n", p, l, b, (n > 0 ? b / n : 0), r
+    }'
+done
+
+if command -v hadd > /dev/null 2>&1; then
+    ROWS=$(sed -n 's/^ *\([0-9]*\) neutrino rows.*/\1/p' bench_output_double_1.log | tail -n 1)
+    for ALGORITHM in 404:lz4 505:zstd; do
+        NAME=bench_output_double_${ALGORITHM#*:}
+        hadd -f${ALGORITHM%:*} $NAME.root bench_output_double_1.root > /dev/null
+        BYTES=$(stat -c%s $NAME.root)
+        awk -v p="double" -v l="${ALGORITHM#*:}" -v b="$BYTES" -v n="$ROWS" 'BEGIN {
+            printf "%-10s %5s %12d %16.2f %10s\n", p, l, b, (n > 0 ? b / n : 0), "(hadd)"
+        }'
+    done
+fi
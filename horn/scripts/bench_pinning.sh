@@ -0,0 +1,52 @@
+#!/bin/bash
+
+# This script compares the events/s of the same job on this machine
+# without pinning and with the workers pinned NUMA node by node
+# (--pin=compact, --pin=scatter), as worker threads or as forked
+# processes (--fork).
+# Run it from the build directory:
+#   ./scripts/bench_pinning.sh [horn current [A]] [seed] [POT] [workers] [threads|fork]
+
+EXE=./mirage_horn
+ARG=${1:-3000}
+SEED=${2:-1234}
+export MIRAGE_POT=${3:-10000}
+NOF_WORKERS=${4:-$(nproc)}
+MODE=${5:-threads}
+MACRO_FILE=macros/bench_threads.mac
+
+if [ "$MODE" = fork ]; then
+    WORKERS="--fork=$NOF_WORKERS"
+else
+    WORKERS="--threads=$NOF_WORKERS"
+fi
+NOF_NODES=$(ls -d /sys/devices/system/node/node[0-9]* 2>/dev/null | wc -l)
+echo "$NOF_WORKERS workers ($MODE) on $(nproc) CPUs, ${NOF_NODES:-1} NUMA nodes"
+
+for PIN in none compact scatter; do
+    NAME=bench_pinning_$PIN
+    echo "Running with $WORKERS --pin=$PIN ..."
+    $EXE $WORKERS --pin=$PIN $MACRO_FILE $ARG $SEED $NAME.root > $NAME.log 2>&1
+    if [ $? -ne 0 ]; then
+        echo "Error: $EXE failed, see $NAME.log"
+        exit 1
+    fi
+done
+
+# the global run summary (threads) or the summary of the parent (fork) is
+# printed last
+printf "%8s %10s %12s %9s\n" pinning time[s] events/s vs_none
+RATE_NONE=""
+for PIN in none compact scatter; do
+    NAME=bench_pinning_$PIN
+    if [ "$MODE" = fork ]; then
+        TIME=$(sed -n 's/.* in \([0-9.]*\) s = .* POT\/s.*/\1/p' $NAME.log | tail -n 1)
+    else
+        TIME=$(sed -n 's/.*real time: \([0-9.e+-]*\) s.*/\1/p' $NAME.log | tail -n 1)
+    fi
+    RATE=$(awk -v n="$MIRAGE_POT" -v t="$TIME" 'BEGIN { printf "%.3f", (t > 0 ? n / t : 0) }')
+    [ -z "$RATE_NONE" ] && RATE_NONE=$RATE
+    awk -v p="$PIN" -v t="$TIME" -v r="$RATE" -v r0="$RATE_NONE" 'BEGIN {
+        printf "%8s %10.2f %12.2f %+8.1f%%\n", p, t, r, (r0 > 0 ? 100. * (r / r0 - 1) : 0)
+    }'
+done
@@ -0,0 +1,29 @@
+#!/bin/bash
+
+# This script merges the files of a run written with /mirage/output/merge
+# false or /mirage/output/roll into one file: the master file (run ntuple
+# and histograms), if any, and the per-thread or rolled files listed in the
+# manifest. The runs tree keeps the run row of every part as well.
+#   ./scripts/merge_manifest.sh result.manifest [merged.root]
+
+MANIFEST=$1
+if [ -z "$MANIFEST" ] || [ ! -f "$MANIFEST" ]; then
+    echo "Usage: $0 <name>.manifest [output.root]"
+    exit 1
+fi
+OUTPUT=${2:-${MANIFEST%.manifest}_merged.root}
+DIR=$(dirname "$MANIFEST")
+
+# file names in the manifest are relative to it
+RUNS=$(awk '$1 == "runs" { print $2 }' "$MANIFEST")
+PARTS=$(awk '$1 == "part" { print $2 }' "$MANIFEST")
+FILES=""
+if [ -n "$RUNS" ]; then
+    FILES="$DIR/$RUNS"
+fi
+for PART in $PARTS; do
+    FILES="$FILES $DIR/$PART"
+done
+
+echo "Merging $(echo $PARTS | wc -w) parts, $(awk '$1 == "pot" { print $2 }' "$MANIFEST") POT, into $OUTPUT ..."
+hadd -f "$OUTPUT" $FILES
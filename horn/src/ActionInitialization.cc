@@ -32,6 +32,7 @@
 #include "EventAction.hh"
 #include "PrimaryGeneratorAction.hh"
 #include "RunAction.hh"
+#include "StackingAction.hh"
 #include "SteppingAction.hh"
 
 namespace mirage_horn
@@ -39,9 +40,10 @@ namespace mirage_horn
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-ActionInitialization::ActionInitialization(G4String fileName)
+ActionInitialization::ActionInitialization(G4String fileName, G4long seed)
   : G4VUserActionInitialization(),
-    fFileName(fileName)
+    fFileName(fileName),
+    fSeed(seed)
 {
 }
 
@@ -50,6 +52,7 @@ ActionInitialization::ActionInitialization(G4String fileName)
 void ActionInitialization::BuildForMaster() const
 {
   auto runAction = new RunAction(fFileName);
+  runAction->GetEventSeeds()->SetRunSeed(fSeed);
   SetUserAction(runAction);
 }
 
@@ -57,15 +60,23 @@ void ActionInitialization::BuildForMaster() const
 
 void ActionInitialization::Build() const
 {
-  SetUserAction(new PrimaryGeneratorAction);
-
   auto runAction = new RunAction(fFileName);
+  runAction->GetEventSeeds()->SetRunSeed(fSeed);
   SetUserAction(runAction);
 
+  SetUserAction(new PrimaryGeneratorAction(runAction->GetEventSeeds()));
+
   auto eventAction = new EventAction(runAction);
   SetUserAction(eventAction);
 
-  SetUserAction(new SteppingAction(eventAction));
+  SetUserAction(new SteppingAction(eventAction, runAction->GetSteppingContext(),
+                                   runAction->GetParentStore(),
+                                   runAction->GetLocationWeights(),
+                                   runAction->GetProjectionPlanes(),
+                                   runAction->GetFluxHistograms(),
+                                   runAction->GetConvergenceMonitor()));
+
+  SetUserAction(new StackingAction(runAction));
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,54 @@
+/// \file mirage_horn/src/DecayMultiplexer.cc
+/// \brief Implementation of the mirage_horn::DecayMultiplexer class
+
+#include "DecayMultiplexer.hh"
+
+#include "G4GenericMessenger.hh"
+#include "G4SystemOfUnits.hh"
+#include "Randomize.hh"
+
+namespace mirage_horn
+{
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+DecayMultiplexer::DecayMultiplexer()
+{
+  DefineCommands();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+DecayMultiplexer::~DecayMultiplexer()
+{
+  delete fMessenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+const mirage::DecayKinematics::NeutrinoBatch& DecayMultiplexer::Sample(
+  G4int parentPDG, const G4ThreeVector& parentMom)
+{
+  // the run's engine, so the extra decays are reproducible from the seed
+  auto flat = [](G4int n, G4double* u) { G4Random::getTheEngine()->flatArray(n, u); };
+  fSampler.Decay(parentPDG, parentMom.x() / GeV, parentMom.y() / GeV, parentMom.z() / GeV,
+                 fNofDecays, flat, fBatch);
+  return fBatch;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DecayMultiplexer::DefineCommands()
+{
+  fMessenger = new G4GenericMessenger(this, "/mirage/multiplex/", "Decay multiplexing control");
+
+  fMessenger->DeclareProperty("nofDecays", fNofDecays)
+    .SetGuidance("Extra analytic decays per pi+-, K+-, K0L and mu+- decay (0 = off).")
+    .SetGuidance("Each of the K+1 decays is written with 1/(K+1) of the parent weight.")
+    .SetParameterName("K", false)
+    .SetRange("K>=0");
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}  // namespace mirage_horn
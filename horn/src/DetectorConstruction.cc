@@ -11,6 +11,17 @@
 #include "G4PVPlacement.hh"
 #include "G4SystemOfUnits.hh"
 #include "G4PhysicalConstants.hh"
+#include "G4SubtractionSolid.hh"
+#include "G4Region.hh"
+#include "G4RegionStore.hh"
+#include "G4ProductionCuts.hh"
+#include "G4UIcommand.hh"
+#include "G4GenericMessenger.hh"
+#include "G4LogicalVolumeStore.hh"
+#include "G4AutoDelete.hh"
+
+// Biasing
+#include "DecayBiasingOperator.hh"
 
 // 자기장 헤더
 #include "SimpleHornMagneticField.hh" // 이전에 만든 파일
@@ -20,34 +31,79 @@
 #include "G4NystromRK4.hh"
 #include "G4ClassicalRK4.hh"
 #include "G4Mag_UsualEqRhs.hh"
+#include "G4UserLimits.hh"
 
 // 시각화 헤더
 #include "G4VisAttributes.hh"
 #include "G4Colour.hh"
 
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <sstream>
+
+namespace
+{
+  // 혼 하나의 스레드별 자기장 객체: stepper와 chord finder는 적분 상태를
+  // 가지므로 스레드 사이에 공유할 수 없음 (삭제는 선언의 역순)
+  struct MagnetField
+  {
+    std::unique_ptr<SimpleHornMagneticField> field;
+    std::unique_ptr<G4Mag_UsualEqRhs> equation;
+    std::unique_ptr<G4MagIntegratorStepper> stepper;
+    std::unique_ptr<G4ChordFinder> chordFinder;
+    std::unique_ptr<G4FieldManager> fieldManager;
+  };
+
+  // 이 스레드의 자기장; geometry를 다시 만들면 교체, 스레드가 끝날 때 삭제
+  G4ThreadLocal std::vector<MagnetField>* threadFields = nullptr;
+
+  MagnetField MakeHornField(G4double current)
+  {
+    MagnetField magnet;
+    magnet.field.reset(new SimpleHornMagneticField(current));
+    magnet.equation.reset(new G4Mag_UsualEqRhs(magnet.field.get()));
+    magnet.stepper.reset(new G4NystromRK4(magnet.equation.get()));
+    G4double minStep = 0.01 * mm; // 최소 스텝
+    magnet.chordFinder.reset(new G4ChordFinder(magnet.field.get(), minStep, magnet.stepper.get()));
+    magnet.chordFinder->SetDeltaChord(0.1 * mm);
+
+    magnet.fieldManager.reset(new G4FieldManager());
+    magnet.fieldManager->SetDetectorField(magnet.field.get());
+    magnet.fieldManager->SetChordFinder(magnet.chordFinder.get());
+    magnet.fieldManager->SetDeltaIntersection(1e-4 * mm); // 경계 교차 정확도 설정
+    magnet.fieldManager->SetDeltaOneStep(1e-4 * mm);      // 한 스텝의 정확도 설정
+    return magnet;
+  }
+}
+
 DetectorConstruction::DetectorConstruction()
 : G4VUserDetectorConstruction(),
-  fMagFieldA(nullptr), fMagFieldB(nullptr), fMagFieldC(nullptr),
-  fFieldMgrA(nullptr), fFieldMgrB(nullptr), fFieldMgrC(nullptr),
   logicInnerCondA(nullptr), logicFieldRegionA(nullptr), logicOuterCondA(nullptr),
   logicInnerCondB(nullptr), logicFieldRegionB(nullptr), logicOuterCondB(nullptr),
-  logicInnerCondC(nullptr), logicFieldRegionC(nullptr), logicOuterCondC(nullptr)
+  logicInnerCondC(nullptr), logicFieldRegionC(nullptr), logicOuterCondC(nullptr),
+  fMessenger(nullptr), fEnvelope(false), fDecayPipeRadius(2.0 * m), fAbsorberZ(0.),
+  fDecayBiasing(false)
 {
+  DefineCommands();
 }
 
 DetectorConstruction::~DetectorConstruction()
 {
-  delete fMagFieldA;
-  delete fMagFieldB;
-  delete fMagFieldC;
-  delete fFieldMgrA;
-  delete fFieldMgrB;
-  delete fFieldMgrC;
+  delete fMessenger;
+}
+
+G4double DetectorConstruction::GetHornCurrent() const
+{
+  // 세 혼 모두 같은 전류
+  return fMagnets.empty() ? 0. : fMagnets.front().current;
 }
 
 G4VPhysicalVolume* DetectorConstruction::Construct()
 {
   G4VPhysicalVolume* physWorld = nullptr;
+  fFieldRegionBounds.clear();
+  fMagnets.clear();
 
   // 1. Construct World
   ConstructWorld(physWorld);
@@ -55,6 +111,10 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
   // Get world logical volume
   G4LogicalVolume* logicWorld = physWorld->GetLogicalVolume();
 
+  // 월드 영역의 tracking floor (/mirage/geometry/minEkine DefaultRegionForTheWorld ...)
+  G4Region* worldRegion = G4RegionStore::GetInstance()->GetRegion("DefaultRegionForTheWorld", false);
+  if (worldRegion && !worldRegion->GetUserLimits()) worldRegion->SetUserLimits(new G4UserLimits());
+
   // 2. Construct Horn Geometry and Magnetic Fields
   ConstructHornA(logicWorld);
   ConstructHornB(logicWorld);
@@ -62,9 +122,36 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
 
   // (Optional) Additional geometry components can be constructed here
 
+  // 3. 빔라인 바깥을 kill 볼륨으로 덮음 (선택 사항)
+  if (fEnvelope) ConstructEnvelope(logicWorld);
+
   return physWorld;
 }
 
+void DetectorConstruction::ConstructSDandField()
+{
+  // 스레드(마스터와 각 워커)마다 자기장, stepper, chord finder, field manager를 생성
+  std::vector<MagnetField> fields;
+  for (const auto& magnet : fMagnets) {
+    fields.push_back(MakeHornField(magnet.current));
+    magnet.volume->SetFieldManager(fields.back().fieldManager.get(), true);
+  }
+  if (!threadFields) {
+    threadFields = new std::vector<MagnetField>();
+    G4AutoDelete::Register(threadFields);
+  }
+  // 이전 geometry의 객체는 새 field manager가 붙은 뒤 여기서 삭제
+  threadFields->swap(fields);
+
+  if (!fDecayBiasing) return;
+
+  // 월드 볼륨(decay 영역)에서만 decay를 biasing; 혼 안은 analog
+  // operator는 워커마다 하나씩 생성됨
+  G4LogicalVolume* logicWorld = G4LogicalVolumeStore::GetInstance()->GetVolume("LogicWorld");
+  auto biasingOperator = new mirage_horn::DecayBiasingOperator();
+  biasingOperator->AttachTo(logicWorld);
+}
+
 
 void DetectorConstruction::ConstructWorld(G4VPhysicalVolume*& physWorld)
 {
@@ -181,21 +268,8 @@ void DetectorConstruction::ConstructHornA(G4LogicalVolume* logicWorld)
                                         aluminum_mat,
                                         "LogicOuterCondA");
   // --- 5. 자기장 생성 및 할당 ---
-  fMagFieldA = new SimpleHornMagneticField(current);
-
-  fFieldMgrA = new G4FieldManager();
-  fFieldMgrA->SetDetectorField(fMagFieldA);
-
-  G4Mag_UsualEqRhs* equationOfMotion = new G4Mag_UsualEqRhs(fMagFieldA);
-  G4MagIntegratorStepper* stepper = new G4NystromRK4(equationOfMotion);
-  G4double minStep = 0.01 * mm; // 최소 스텝
-  G4ChordFinder* chordFinder = new G4ChordFinder(fMagFieldA, minStep, stepper);
-  chordFinder->SetDeltaChord(0.1 * mm);
-  fFieldMgrA->SetChordFinder(chordFinder);
-  fFieldMgrA->SetDeltaIntersection(1e-4 * mm); // 경계 교차 정확도 설정
-  fFieldMgrA->SetDeltaOneStep(1e-4 * mm);      // 한 스텝의 정확도 설정
-
-  logicFieldRegionA->SetFieldManager(fFieldMgrA, true); // Assign magnetic field only to this volume.
+  // 자기장은 ConstructSDandField()에서 스레드마다 생성하여 이 볼륨에만 할당
+  fMagnets.push_back({logicFieldRegionA, current});
 
 
   // --- 6. 볼륨 배치 (logicWorld에 배치) ---
@@ -206,6 +280,20 @@ void DetectorConstruction::ConstructHornA(G4LogicalVolume* logicWorld)
   new G4PVPlacement(0, origin, logicFieldRegionA, "FieldRegion_PV", logicWorld, false, 0);
   new G4PVPlacement(0, origin, logicOuterCondA, "OuterCond_PV", logicWorld, false, 0);
 
+  // 혼 영역: 도체와 자기장 영역 전체
+  G4Region* region = CreateRegion("HornA");
+  region->AddRootLogicalVolume(logicInnerCondA);
+  region->AddRootLogicalVolume(logicFieldRegionA);
+  region->AddRootLogicalVolume(logicOuterCondA);
+
+  // 내부 도체 표면(최소 반경)에서의 자기장 * 길이 = B*L 상한
+  G4double rMin = rOuter_Inner[0];
+  for (G4int i = 1; i < numZPlanes; ++i) rMin = std::min(rMin, rOuter_Inner[i]);
+  G4double length = zPlane[numZPlanes - 1] - zPlane[0];
+  fFieldRegionBounds.push_back({origin.z() + zPlane[0],
+                                origin.z() + zPlane[numZPlanes - 1],
+                                mu0 * std::abs(current) / (twopi * rMin) * length});
+
   // --- 7. 시각화 속성 (선택 사항) ---
   G4VisAttributes* visAttrInner = new G4VisAttributes(G4Colour(0.5, 0.5, 0.5)); // Grey
   logicInnerCondA->SetVisAttributes(visAttrInner);
@@ -240,6 +328,10 @@ void DetectorConstruction::ConstructHornA(G4LogicalVolume* logicWorld)
                     logicWorld,
                     false,
                     0);
+
+  // 타겟 영역: EM 샤워 비용이 가장 큰 곳
+  G4Region* targetRegion = CreateRegion("Target");
+  targetRegion->AddRootLogicalVolume(logicTarget);
 }
 
 void DetectorConstruction::ConstructHornB(G4LogicalVolume* logicWorld)
@@ -342,20 +434,8 @@ void DetectorConstruction::ConstructHornB(G4LogicalVolume* logicWorld)
                                         "LogicOuterCondB");
 
   // --- 5. 자기장 생성 및 할당 ---
-  fMagFieldB = new SimpleHornMagneticField(current);
-
-  fFieldMgrB = new G4FieldManager();
-  fFieldMgrB->SetDetectorField(fMagFieldB);
-  G4Mag_UsualEqRhs* equationOfMotion = new G4Mag_UsualEqRhs(fMagFieldB);
-  G4MagIntegratorStepper* stepper = new G4NystromRK4(equationOfMotion);
-  G4double minStep = 0.01 * mm; // 최소 스텝
-  G4ChordFinder* chordFinder = new G4ChordFinder(fMagFieldB, minStep, stepper);
-  chordFinder->SetDeltaChord(0.1 * mm);
-  fFieldMgrB->SetChordFinder(chordFinder);
-  fFieldMgrB->SetDeltaIntersection(1e-4 * mm); // 경계 교차 정확도 설정
-  fFieldMgrB->SetDeltaOneStep(1e-4 * mm);      // 한 스텝의 정확도 설정
-
-  logicFieldRegionB->SetFieldManager(fFieldMgrB, true); // Assign magnetic field only to this volume.
+  // 자기장은 ConstructSDandField()에서 스레드마다 생성하여 이 볼륨에만 할당
+  fMagnets.push_back({logicFieldRegionB, current});
 
   // --- 6. 볼륨 배치 (logicWorld에 배치) ---
   // G4Polycone은 zPlane에 정의된 절대 Z 좌표에 이미 위치하므로,
@@ -365,6 +445,20 @@ void DetectorConstruction::ConstructHornB(G4LogicalVolume* logicWorld)
   new G4PVPlacement(0, origin, logicFieldRegionB, "FieldRegionB_PV", logicWorld, false, 0);
   new G4PVPlacement(0, origin, logicOuterCondB, "OuterCondB_PV", logicWorld, false, 0);
 
+  // 혼 영역: 도체와 자기장 영역 전체
+  G4Region* region = CreateRegion("HornB");
+  region->AddRootLogicalVolume(logicInnerCondB);
+  region->AddRootLogicalVolume(logicFieldRegionB);
+  region->AddRootLogicalVolume(logicOuterCondB);
+
+  // 내부 도체 표면(최소 반경)에서의 자기장 * 길이 = B*L 상한
+  G4double rMin = rOuter_Inner[0];
+  for (G4int i = 1; i < numZPlanes; ++i) rMin = std::min(rMin, rOuter_Inner[i]);
+  G4double length = zPlane[numZPlanes - 1] - zPlane[0];
+  fFieldRegionBounds.push_back({origin.z() + zPlane[0],
+                                origin.z() + zPlane[numZPlanes - 1],
+                                mu0 * std::abs(current) / (twopi * rMin) * length});
+
   // --- 7. 시각화 속성 (선택 사항) ---
   G4VisAttributes* visAttrInner = new G4VisAttributes(G4Colour(0.5, 0.5, 0.5)); // Grey
   logicInnerCondB->SetVisAttributes(visAttrInner);
@@ -482,20 +576,8 @@ void DetectorConstruction::ConstructHornC(G4LogicalVolume* logicWorld)
                                         "LogicOuterCondC");
 
   // --- 5. 자기장 생성 및 할당 ---
-  fMagFieldC = new SimpleHornMagneticField(current);
-
-  fFieldMgrC = new G4FieldManager();
-  fFieldMgrC->SetDetectorField(fMagFieldC);
-  G4Mag_UsualEqRhs* equationOfMotion = new G4Mag_UsualEqRhs(fMagFieldC);
-  G4MagIntegratorStepper* stepper = new G4NystromRK4(equationOfMotion);
-  G4double minStep = 0.01 * mm; // 최소 스텝
-  G4ChordFinder* chordFinder = new G4ChordFinder(fMagFieldC, minStep, stepper);
-  chordFinder->SetDeltaChord(0.1 * mm);
-  fFieldMgrC->SetChordFinder(chordFinder);
-  fFieldMgrC->SetDeltaIntersection(1e-4 * mm); // 경계 교차 정확도 설정
-  fFieldMgrC->SetDeltaOneStep(1e-4 * mm);      // 한 스텝의 정확도 설정
-
-  logicFieldRegionC->SetFieldManager(fFieldMgrC, true); // Assign magnetic field only to this volume.
+  // 자기장은 ConstructSDandField()에서 스레드마다 생성하여 이 볼륨에만 할당
+  fMagnets.push_back({logicFieldRegionC, current});
 
   // --- 6. 볼륨 배치 (logicWorld에 배치) ---
   // G4Polycone은 zPlane에 정의된 절대 Z 좌표에 이미 위치하므로,
@@ -504,6 +586,20 @@ void DetectorConstruction::ConstructHornC(G4LogicalVolume* logicWorld)
   new G4PVPlacement(0, origin, logicInnerCondC, "InnerCondC_PV", logicWorld, false, 0);
   new G4PVPlacement(0, origin, logicFieldRegionC, "FieldRegionC_PV", logicWorld, false, 0);
   new G4PVPlacement(0, origin, logicOuterCondC, "OuterCondC_PV", logicWorld, false, 0);
+
+  // 혼 영역: 도체와 자기장 영역 전체
+  G4Region* region = CreateRegion("HornC");
+  region->AddRootLogicalVolume(logicInnerCondC);
+  region->AddRootLogicalVolume(logicFieldRegionC);
+  region->AddRootLogicalVolume(logicOuterCondC);
+
+  // 내부 도체 표면(최소 반경)에서의 자기장 * 길이 = B*L 상한
+  G4double rMin = rOuter_Inner[0];
+  for (G4int i = 1; i < numZPlanes; ++i) rMin = std::min(rMin, rOuter_Inner[i]);
+  G4double length = zPlane[numZPlanes - 1] - zPlane[0];
+  fFieldRegionBounds.push_back({origin.z() + zPlane[0],
+                                origin.z() + zPlane[numZPlanes - 1],
+                                mu0 * std::abs(current) / (twopi * rMin) * length});
   // --- 7. 시각화 속성 (선택 사항) ---
   G4VisAttributes* visAttrInner = new G4VisAttributes(G4Colour(0.5, 0.5, 0.5)); // Grey
   logicInnerCondC->SetVisAttributes(visAttrInner);
@@ -515,4 +611,122 @@ void DetectorConstruction::ConstructHornC(G4LogicalVolume* logicWorld)
   logicOuterCondC->SetVisAttributes(visAttrOuter);
 
   // --- 8. 월드 반환 ---
-}
\ No newline at end of file
+}
+
+void DetectorConstruction::ConstructEnvelope(G4LogicalVolume* logicWorld)
+{
+  // 월드 박스에서 decay pipe 원통을 뺀 영역을 kill 볼륨으로 둡니다.
+  // fAbsorberZ > 0 이면 pipe가 그 위치(월드 상류면 기준)에서 끝나므로
+  // 그 하류 전체가 흡수체(absorber) 역할을 합니다.
+  G4Box* solidWorld = dynamic_cast<G4Box*>(logicWorld->GetSolid());
+  G4double worldHalfZ = solidWorld->GetZHalfLength();
+  G4double margin = 1.0 * m; // 월드 면과 겹치는 면(coincident surface)을 피하기 위한 여유
+  G4double pipeEndZ = (fAbsorberZ > 0.) ? -worldHalfZ + fAbsorberZ : worldHalfZ + margin;
+
+  // 빔라인 요소(타겟, 혼/다이폴)가 모두 pipe 안에 있어야 합니다.
+  for (std::size_t i = 0; i < logicWorld->GetNoDaughters(); ++i) {
+    G4VPhysicalVolume* daughter = logicWorld->GetDaughter(i);
+    G4ThreeVector pMin, pMax;
+    daughter->GetLogicalVolume()->GetSolid()->BoundingLimits(pMin, pMax);
+    pMin += daughter->GetTranslation();
+    pMax += daughter->GetTranslation();
+    G4double xMax = std::max(std::abs(pMin.x()), std::abs(pMax.x()));
+    G4double yMax = std::max(std::abs(pMin.y()), std::abs(pMax.y()));
+    if (std::sqrt(xMax * xMax + yMax * yMax) > fDecayPipeRadius || pMax.z() > pipeEndZ) {
+      G4ExceptionDescription msg;
+      msg << daughter->GetName() << " does not fit inside the beamline envelope"
+          << " (decay pipe radius " << fDecayPipeRadius / m << " m, end at z = "
+          << pipeEndZ / m << " m).";
+      G4Exception("DetectorConstruction::ConstructEnvelope()", "MIRAGE004",
+                  FatalException, msg);
+    }
+  }
+
+  G4double pipeHalfZ = 0.5 * (pipeEndZ + worldHalfZ + margin);
+  G4Tubs* solidPipe = new G4Tubs("SolidDecayPipe",
+                                 0.0,
+                                 fDecayPipeRadius,
+                                 pipeHalfZ,
+                                 0.0 * deg,
+                                 360.0 * deg);
+  G4SubtractionSolid* solidEnvelope = new G4SubtractionSolid("SolidEnvelope",
+                                                             solidWorld,
+                                                             solidPipe,
+                                                             nullptr,
+                                                             G4ThreeVector(0., 0., pipeEndZ - pipeHalfZ));
+  G4LogicalVolume* logicEnvelope = new G4LogicalVolume(solidEnvelope,
+                                                       logicWorld->GetMaterial(),
+                                                       "LogicEnvelope");
+  new G4PVPlacement(0, G4ThreeVector(), logicEnvelope, "PhysEnvelope", logicWorld, false, 0);
+  logicEnvelope->SetVisAttributes(G4VisAttributes::GetInvisible());
+
+  // KillRegion: 최소 운동에너지 DBL_MAX → G4UserSpecialCuts가 첫 스텝에서 트랙을 제거
+  G4Region* killRegion = new G4Region("KillRegion");
+  killRegion->AddRootLogicalVolume(logicEnvelope);
+  killRegion->SetUserLimits(new G4UserLimits(DBL_MAX, DBL_MAX, DBL_MAX, DBL_MAX));
+}
+
+G4Region* DetectorConstruction::CreateRegion(const G4String& name)
+{
+  // 월드의 기본 cut으로 시작하며 /run/setCutForRegion 으로 바꿀 수 있습니다.
+  // tracking floor (minEkine)는 G4UserSpecialCuts가 적용합니다.
+  G4Region* region = new G4Region(name);
+  G4Region* worldRegion = G4RegionStore::GetInstance()->GetRegion("DefaultRegionForTheWorld", false);
+  if (worldRegion && worldRegion->GetProductionCuts()) {
+    region->SetProductionCuts(new G4ProductionCuts(*worldRegion->GetProductionCuts()));
+  }
+  region->SetUserLimits(new G4UserLimits());
+  return region;
+}
+
+void DetectorConstruction::SetRegionMinEkine(const G4String& args)
+{
+  // "<region> <value> <unit>"
+  std::istringstream is(args);
+  G4String name, unit;
+  G4double value = 0.;
+  is >> name >> value >> unit;
+
+  G4Region* region = G4RegionStore::GetInstance()->GetRegion(name, false);
+  if (is.fail() || !region || !region->GetUserLimits()) {
+    G4ExceptionDescription msg;
+    msg << "Cannot set the tracking floor of region <" << name << ">"
+        << " (usage: <region> <value> <unit>, after /run/initialize).";
+    G4Exception("DetectorConstruction::SetRegionMinEkine()", "MIRAGE005",
+                JustWarning, msg);
+    return;
+  }
+  region->GetUserLimits()->SetUserMinEkine(value * G4UIcommand::ValueOf(unit.c_str()));
+}
+
+void DetectorConstruction::DefineCommands()
+{
+  fMessenger = new G4GenericMessenger(this, "/mirage/geometry/", "Geometry control");
+
+  fMessenger->DeclareProperty("envelope", fEnvelope)
+    .SetGuidance("Kill tracks that leave the decay pipe or pass the absorber.")
+    .SetGuidance("Needs SpecialCutsPhysics; set before /run/initialize.")
+    .SetParameterName("flag", true)
+    .SetDefaultValue("true")
+    .SetStates(G4State_PreInit);
+
+  fMessenger->DeclarePropertyWithUnit("decayPipeRadius", "m", fDecayPipeRadius)
+    .SetGuidance("Radius of the beamline envelope around the beam axis.")
+    .SetParameterName("radius", false)
+    .SetRange("radius>0.")
+    .SetStates(G4State_PreInit);
+
+  fMessenger->DeclarePropertyWithUnit("absorberZ", "m", fAbsorberZ)
+    .SetGuidance("Absorber plane, measured from the upstream face of the world.")
+    .SetGuidance("Everything downstream of it is killed; 0 disables the absorber.")
+    .SetParameterName("z", false)
+    .SetRange("z>=0.")
+    .SetStates(G4State_PreInit);
+
+  fMessenger->DeclareMethod("minEkine", &DetectorConstruction::SetRegionMinEkine)
+    .SetGuidance("Tracking floor of a region: kill any track below this kinetic energy.")
+    .SetGuidance("Usage: minEkine <region> <value> <unit>, e.g. minEkine Target 10 MeV")
+    .SetGuidance("Regions: Target, Dipole/Horn A-C, DefaultRegionForTheWorld.")
+    .SetParameterName("args", false)
+    .SetStates(G4State_Idle);
+}
@@ -0,0 +1,197 @@
+/// \file mirage_horn/src/FluxHistograms.cc
+/// \brief Implementation of the mirage_horn::FluxHistograms class
+
+#include "FluxHistograms.hh"
+
+#include "FluxWindow.hh"
+
+#include "G4GenericMessenger.hh"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+namespace mirage_horn
+{
+
+namespace
+{
+  // values of a row before its columns
+  const char* kNeutrinoValues[4] = {"daughterE", "daughterPx", "daughterPy", "daughterPz"};
+
+  G4bool ParseFlavour(const G4String& name, G4int& pdg)
+  {
+    static const char* names[5] = {"all", "numu", "numubar", "nue", "nuebar"};
+    static const G4int pdgs[5] = {0, 14, -14, 12, -12};
+    for (G4int i = 0; i < 5; ++i) {
+      if (name == names[i]) {
+        pdg = pdgs[i];
+        return true;
+      }
+    }
+    return false;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+FluxHistograms::FluxHistograms()
+{
+  DefineCommands();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+FluxHistograms::~FluxHistograms()
+{
+  delete fMessenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void FluxHistograms::Book(G4AnalysisManager* analysisManager,
+                          const std::vector<G4String>& columnNames)
+{
+  fHistograms.clear();
+  if (fConfigs.empty()) return;
+
+  auto index = [&](const G4String& name) -> G4int {
+    for (G4int i = 0; i < 4; ++i) {
+      if (name == kNeutrinoValues[i]) return i;
+    }
+    const auto it = std::find(columnNames.begin(), columnNames.end(), name);
+    return it == columnNames.end() ? -1 : 4 + static_cast<G4int>(it - columnNames.begin());
+  };
+  fWindowX = index("projXat574m") - 4;
+  fWindowY = index("projYat574m") - 4;
+
+  for (const auto& config : fConfigs) {
+    const G4int x = index(config.x);
+    const G4int y = config.dimension == 2 ? index(config.y) : 0;
+    const G4bool window = config.selection != kWindow || (fWindowX >= 0 && fWindowY >= 0);
+    if (x < 0 || y < 0 || !window) {
+      G4ExceptionDescription msg;
+      msg << "Histogram " << config.name << ": "
+          << (window ? "unknown column " + (x < 0 ? config.x : config.y)
+                     : G4String("the ff selection needs the at574m plane"))
+          << "; it is not booked.";
+      G4Exception("FluxHistograms::Book()", "MIRAGE013", JustWarning, msg);
+      continue;
+    }
+
+    G4int id = -1;
+    if (config.dimension == 1) {
+      id = analysisManager->CreateH1(config.name, config.name + "; " + config.x,
+                                     config.nofBinsX, config.minX, config.maxX);
+    }
+    else {
+      id = analysisManager->CreateH2(config.name, config.name + "; " + config.x + "; " + config.y,
+                                     config.nofBinsX, config.minX, config.maxX,
+                                     config.nofBinsY, config.minY, config.maxY);
+    }
+    fHistograms.push_back({id, config.dimension, config.pdg, config.selection, x, y});
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void FluxHistograms::Fill(G4AnalysisManager* analysisManager, G4int pdg, G4double E,
+                          G4double px, G4double py, G4double pz, G4double weight,
+                          const G4double* columns) const
+{
+  if (fHistograms.empty()) return;
+
+  const G4double values[4] = {E, px, py, pz};
+  auto value = [&](G4int i) { return i < 4 ? values[i] : columns[i - 4]; };
+  const G4bool forward = pz > 0.;
+  const G4bool inWindow = forward && fWindowX >= 0 &&
+                          mirage::FluxWindow::Contains(columns[fWindowX], columns[fWindowY]);
+
+  for (const auto& histogram : fHistograms) {
+    if (histogram.pdg != 0 && histogram.pdg != pdg) continue;
+    if (histogram.selection == kForward && !forward) continue;
+    if (histogram.selection == kWindow && !inWindow) continue;
+    if (histogram.dimension == 1) {
+      analysisManager->FillH1(histogram.id, value(histogram.x), weight);
+    }
+    else {
+      analysisManager->FillH2(histogram.id, value(histogram.x), value(histogram.y), weight);
+    }
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void FluxHistograms::ReadConfig(const G4String& fileName)
+{
+  std::ifstream file(fileName);
+  if (!file) {
+    G4ExceptionDescription msg;
+    msg << "Cannot read the histogram configuration " << fileName << ".";
+    G4Exception("FluxHistograms::ReadConfig()", "MIRAGE013", JustWarning, msg);
+    return;
+  }
+
+  std::string line;
+  G4int lineNumber = 0;
+  while (std::getline(file, line)) {
+    ++lineNumber;
+    const std::size_t comment = line.find('#');
+    if (comment != std::string::npos) line.erase(comment);
+    std::istringstream is(line);
+    std::string type;
+    if (!(is >> type)) continue;
+
+    Config config{};
+    std::string flavour, selection;
+    G4bool valid = (type == "h1" || type == "h2") &&
+                   static_cast<bool>(is >> config.name >> flavour >> selection >> config.x
+                                        >> config.nofBinsX >> config.minX >> config.maxX);
+    config.dimension = type == "h2" ? 2 : 1;
+    if (valid && config.dimension == 2) {
+      valid = static_cast<bool>(is >> config.y >> config.nofBinsY >> config.minY >> config.maxY);
+    }
+    valid = valid && ParseFlavour(flavour, config.pdg);
+    if (selection == "all") config.selection = kAll;
+    else if (selection == "forward") config.selection = kForward;
+    else if (selection == "ff") config.selection = kWindow;
+    else valid = false;
+
+    if (!valid || config.nofBinsX <= 0 || (config.dimension == 2 && config.nofBinsY <= 0)) {
+      G4ExceptionDescription msg;
+      msg << fileName << ":" << lineNumber << ": expected \"h1 <name> <flavour> <selection>"
+          << " <x> <bins> <min> <max>\" or h2 with a y axis, got \"" << line << "\".";
+      G4Exception("FluxHistograms::ReadConfig()", "MIRAGE013", JustWarning, msg);
+      continue;
+    }
+    fConfigs.push_back(config);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void FluxHistograms::ClearConfigs()
+{
+  fConfigs.clear();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void FluxHistograms::DefineCommands()
+{
+  fMessenger = new G4GenericMessenger(this, "/mirage/histograms/", "In-simulation flux histograms");
+
+  fMessenger->DeclareMethod("config", &FluxHistograms::ReadConfig)
+    .SetGuidance("Add the histograms of a configuration file (see flux_histograms.cfg),")
+    .SetGuidance("booked at the next run.")
+    .SetParameterName("fileName", false)
+    .SetStates(G4State_PreInit, G4State_Idle);
+
+  fMessenger->DeclareMethod("clear", &FluxHistograms::ClearConfigs)
+    .SetGuidance("Remove all configured histograms.")
+    .SetStates(G4State_PreInit, G4State_Idle);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}  // namespace mirage_horn
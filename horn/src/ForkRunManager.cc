@@ -0,0 +1,223 @@
+/// \file mirage_horn/src/ForkRunManager.cc
+/// \brief Implementation of the mirage_horn::ForkRunManager class
+
+#include "ForkRunManager.hh"
+
+#include "EventSeeds.hh"
+#include "RunManifest.hh"
+
+#include "NumaLayout.hh"
+
+#include "G4ios.hh"
+#include "Randomize.hh"
+
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace mirage_horn
+{
+
+namespace
+{
+  // interval of the memory samples of the processes
+  const std::chrono::milliseconds kSampleInterval(200);
+
+  G4double SecondsSince(std::chrono::steady_clock::time_point start)
+  {
+    return std::chrono::duration<G4double>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  // proportional set size of a process in kB (shared pages divided among the
+  // processes that map them), 0 where /proc/<pid>/smaps_rollup is missing
+  G4long ReadPSS(const std::string& process)
+  {
+    std::ifstream file("/proc/" + process + "/smaps_rollup");
+    std::string line;
+    while (std::getline(file, line)) {
+      if (line.compare(0, 4, "Pss:") != 0) continue;
+      std::istringstream words(line.substr(4));
+      G4long kB = 0;
+      words >> kB;
+      return kB;
+    }
+    return 0;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+ForkRunManager::ForkRunManager(G4int nofProcesses, const G4String& outputName, G4long seed)
+  : G4RunManager(),
+    fNofProcesses(nofProcesses),
+    fOutputName(outputName),
+    fSeed(seed)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ForkRunManager::BeamOn(G4int nofEvents, const char* macroFile, G4int nofSelect)
+{
+  // the processes run their share of every run of the macro
+  if (fProcess >= 0 || nofEvents <= 0) {
+    G4RunManager::BeamOn(nofEvents, macroFile, nofSelect);
+    return;
+  }
+
+  // geometry and physics tables, shared by the processes
+  auto start = std::chrono::steady_clock::now();
+  G4RunManager::BeamOn(0);
+  const G4double initTime = SecondsSince(start);
+
+  G4cout << G4endl << " Forking " << fNofProcesses << " processes for " << nofEvents
+         << " events" << G4endl << std::flush;
+  // nothing buffered may be written twice
+  std::fflush(nullptr);
+
+  start = std::chrono::steady_clock::now();
+  std::vector<Process> processes;
+  for (G4int process = 0; process < fNofProcesses; ++process) {
+    const pid_t pid = fork();
+    if (pid == 0) {
+      // the process goes on with the rest of the macro and returns from main()
+      RunProcess(process, nofEvents, macroFile, nofSelect);
+      return;
+    }
+    if (pid < 0) {
+      for (const auto& running : processes) kill(running.pid, SIGTERM);
+      G4ExceptionDescription msg;
+      msg << "Cannot fork process " << process << ": " << std::strerror(errno) << ".";
+      G4Exception("ForkRunManager::BeamOn()", "MIRAGE017", FatalException, msg);
+    }
+    processes.push_back({pid});
+  }
+
+  G4long peakPSS = 0;
+  WaitForProcesses(processes, peakPSS);
+  const G4double time = SecondsSince(start);
+  const G4long nofPOT = RunManifest::MergeProcesses(fOutputName, fNofProcesses, fSeed);
+
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  G4int nofFailed = 0;
+  G4cout
+    << G4endl
+    << "--------------------Forked processes------------------------" << G4endl
+    << std::fixed << std::setprecision(1)
+    << " initialisation: " << initTime << " s (once, in the parent; peak RSS "
+    << usage.ru_maxrss / 1024. << " MB)" << G4endl;
+  for (std::size_t process = 0; process < processes.size(); ++process) {
+    const Process& forked = processes[process];
+    const G4int status = forked.status;
+    G4cout << " p" << process << ": events " << FirstEvent(process, nofEvents) << "-"
+           << FirstEvent(process + 1, nofEvents) - 1 << ", peak RSS "
+           << forked.peakRSS / 1024. << " MB, peak PSS " << forked.peakPSS / 1024. << " MB, ";
+    if (WIFEXITED(status)) G4cout << "exit " << WEXITSTATUS(status);
+    else if (WIFSIGNALED(status)) G4cout << "signal " << WTERMSIG(status);
+    G4cout << G4endl;
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) ++nofFailed;
+  }
+  G4cout
+    << " processes: " << fNofProcesses << ", failed: " << nofFailed << ", POT: " << nofPOT
+    << " in " << time << " s = " << (time > 0. ? nofPOT / time : 0.) << " POT/s" << G4endl
+    << " aggregate peak PSS (parent and processes): " << peakPSS / 1024. << " MB" << G4endl
+    << std::defaultfloat
+    << "------------------------------------------------------------" << G4endl << std::flush;
+
+  if (nofFailed > 0) {
+    G4ExceptionDescription msg;
+    msg << nofFailed << " of the " << fNofProcesses << " processes failed.";
+    G4Exception("ForkRunManager::BeamOn()", "MIRAGE017", JustWarning, msg);
+  }
+  // the processes ran the rest of the macro
+  std::fflush(nullptr);
+  std::_Exit(nofFailed > 0 ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ForkRunManager::DoEventLoop(G4int nofEvents, const char* macroFile, G4int nofSelect)
+{
+  if (fProcess < 0) {
+    G4RunManager::DoEventLoop(nofEvents, macroFile, nofSelect);
+    return;
+  }
+
+  InitializeEventLoop(nofEvents, macroFile, nofSelect);
+  // the events keep their IDs in the job, as those of the worker threads
+  const G4int lastEvent = FirstEvent(fProcess + 1, nofEvents);
+  for (G4int eventID = FirstEvent(fProcess, nofEvents); eventID < lastEvent; ++eventID) {
+    ProcessOneEvent(eventID);
+    TerminateOneEvent();
+    if (runAborted) break;
+  }
+  TerminateEventLoop();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ForkRunManager::RunProcess(G4int process, G4int nofEvents, const char* macroFile,
+                                G4int nofSelect)
+{
+  fProcess = process;
+  RunManifest::SetProcess(process);
+  // --pin: the pages the process writes from now on are on its node
+  const G4int cpu = mirage::NumaLayout::PinWorker(process);
+  if (cpu >= 0) G4cout << " Process " << process << " pinned to CPU " << cpu << G4endl;
+
+  // a stream of its own, apart from those of the events (perEvent)
+  long seeds[3];
+  EventSeeds::GetSeeds(fSeed, -1 - process, seeds);
+  G4Random::getTheEngine()->setSeeds(seeds, 2);
+
+  G4RunManager::BeamOn(nofEvents, macroFile, nofSelect);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ForkRunManager::WaitForProcesses(std::vector<Process>& processes, G4long& peakPSS) const
+{
+  std::size_t nofRunning = processes.size();
+  while (nofRunning > 0) {
+    G4long pss = ReadPSS("self");
+    for (auto& process : processes) {
+      if (!process.running) continue;
+      const G4long processPSS = ReadPSS(std::to_string(process.pid));
+      process.peakPSS = std::max(process.peakPSS, processPSS);
+      pss += processPSS;
+
+      struct rusage usage;
+      if (wait4(process.pid, &process.status, WNOHANG, &usage) == process.pid) {
+        process.peakRSS = usage.ru_maxrss;
+        process.running = false;
+        --nofRunning;
+      }
+    }
+    peakPSS = std::max(peakPSS, pss);
+    if (nofRunning > 0) std::this_thread::sleep_for(kSampleInterval);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int ForkRunManager::FirstEvent(G4int process, G4int nofEvents) const
+{
+  return static_cast<G4int>(G4long(process) * nofEvents / fNofProcesses);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}  // namespace mirage_horn
@@ -0,0 +1,168 @@
+/// \file mirage_horn/src/LocationWeights.cc
+/// \brief Implementation of the mirage_horn::LocationWeights class
+
+#include "LocationWeights.hh"
+
+#include "LocationWeight.hh"
+
+#include "G4GenericMessenger.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4UIcommand.hh"
+
+#include <sstream>
+
+namespace mirage_horn
+{
+
+namespace
+{
+  const char* kFlavourNames[4] = {"numu", "numubar", "nue", "nuebar"};
+
+  G4int FlavourIndex(G4int pdg)
+  {
+    switch (pdg) {
+      case 14: return 0;
+      case -14: return 1;
+      case 12: return 2;
+      case -12: return 3;
+      default: return -1;
+    }
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+LocationWeights::LocationWeights()
+{
+  DefineCommands();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+LocationWeights::~LocationWeights()
+{
+  delete fMessenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void LocationWeights::BookColumns(G4AnalysisManager* analysisManager) const
+{
+  for (const auto& name : GetColumnNames()) {
+    analysisManager->CreateNtupleDColumn(name);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+std::vector<G4String> LocationWeights::GetColumnNames() const
+{
+  std::vector<G4String> names;
+  for (const auto& location : fLocations) {
+    names.push_back(location.name + "Weight");
+    names.push_back(location.name + "E");
+  }
+  return names;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void LocationWeights::Book(G4AnalysisManager* analysisManager, G4double worldHalfZ)
+{
+  for (auto& location : fLocations) {
+    location.z = location.distance - worldHalfZ / m;
+  }
+
+  fFirstH1 = -1;
+  if (!fHistograms) return;
+  for (const auto& location : fLocations) {
+    for (const char* flavour : kFlavourNames) {
+      G4String name = location.name + "_" + flavour;
+      G4String title = name + " flux at the location; E [GeV]; neutrinos / m^{2}";
+      G4int id = analysisManager->CreateH1(name, title, 200, 0., 20.);
+      if (fFirstH1 < 0) fFirstH1 = id;
+    }
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void LocationWeights::Fill(G4AnalysisManager* analysisManager, G4double* columns,
+                           const G4ThreeVector& parentMom, G4double parentE,
+                           const G4ThreeVector& decayPos, G4int nuPDG,
+                           const G4ThreeVector& nuMom, G4double nuE, G4double weight) const
+{
+  if (fLocations.empty()) return;
+
+  const G4double parent[4] = {parentMom.x() / GeV, parentMom.y() / GeV, parentMom.z() / GeV,
+                              parentE / GeV};
+  const G4double vertex[3] = {decayPos.x() / m, decayPos.y() / m, decayPos.z() / m};
+  const G4double neutrino[4] = {nuMom.x() / GeV, nuMom.y() / GeV, nuMom.z() / GeV, nuE / GeV};
+  const G4int flavour = FlavourIndex(nuPDG);
+
+  for (std::size_t i = 0; i < fLocations.size(); ++i) {
+    const Location& location = fLocations[i];
+    const G4double point[3] = {location.x, location.y, location.z};
+    G4double locationWeight = 0., energy = 0.;
+    mirage::LocationWeight::Compute(parent, vertex, neutrino, point, locationWeight, energy);
+
+    columns[2 * i] = locationWeight;
+    columns[2 * i + 1] = energy;
+    if (fFirstH1 >= 0 && flavour >= 0) {
+      analysisManager->FillH1(fFirstH1 + 4 * i + flavour, energy, weight * locationWeight);
+    }
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void LocationWeights::AddLocation(const G4String& args)
+{
+  std::istringstream is(args);
+  G4String name, unit = "m";
+  G4double x = 0., y = 0., distance = 0.;
+  if (!(is >> name >> x >> y >> distance)) {
+    G4ExceptionDescription msg;
+    msg << "Expected \"<name> <x> <y> <distance> [unit]\", got \"" << args << "\".";
+    G4Exception("LocationWeights::AddLocation()", "MIRAGE008", JustWarning, msg);
+    return;
+  }
+  is >> unit;
+
+  const G4double toMetre = G4UIcommand::ValueOf(unit.c_str()) / m;
+  fLocations.push_back({name, x * toMetre, y * toMetre, distance * toMetre, 0.});
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void LocationWeights::ClearLocations()
+{
+  fLocations.clear();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void LocationWeights::DefineCommands()
+{
+  fMessenger = new G4GenericMessenger(this, "/mirage/locations/", "Detector location weights");
+
+  fMessenger->DeclareMethod("add", &LocationWeights::AddLocation)
+    .SetGuidance("Add a detector location: <name> <x> <y> <distance> [unit].")
+    .SetGuidance("x and y in the world frame, distance from the upstream face of the world.")
+    .SetGuidance("Adds the columns <name>Weight and <name>E to the mirage ntuple.")
+    .SetParameterName("location", false)
+    .SetStates(G4State_PreInit, G4State_Idle);
+
+  fMessenger->DeclareMethod("clear", &LocationWeights::ClearLocations)
+    .SetGuidance("Remove all detector locations.")
+    .SetStates(G4State_PreInit, G4State_Idle);
+
+  fMessenger->DeclareProperty("histograms", fHistograms)
+    .SetGuidance("Also fill per-location, per-flavour energy histograms.")
+    .SetParameterName("flag", true)
+    .SetDefaultValue("true");
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}  // namespace mirage_horn
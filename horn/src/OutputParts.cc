@@ -0,0 +1,104 @@
+/// \file mirage_horn/src/OutputParts.cc
+/// \brief Implementation of the mirage_horn::OutputParts class
+
+#include "OutputParts.hh"
+
+#include "RunManifest.hh"
+
+#include "G4GenericMessenger.hh"
+
+#include <cstdio>
+#include <fstream>
+
+namespace mirage_horn
+{
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+OutputParts::OutputParts()
+{
+  DefineCommands();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+OutputParts::~OutputParts()
+{
+  delete fMessenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4String OutputParts::Begin(const G4String& outputName, G4bool rolling)
+{
+  fOutputName = outputName;
+  fRolling = rolling;
+  fIndex = -1;
+  return Next(0);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool OutputParts::EndOfEvent(G4int eventID, G4long nofRows)
+{
+  if (fNofEvents++ == 0) fFirstEvent = eventID;
+  fLastEvent = eventID;
+  if (!fRolling) return false;
+
+  if (fMaxRows > 0 && GetNofRows(nofRows) >= fMaxRows) return true;
+  if (fMaxMegabytes > 0.) {
+    // the baskets written so far
+    std::ifstream file(fFileName, std::ios::binary | std::ios::ate);
+    if (file && file.tellg() >= fMaxMegabytes * 1.e6) return true;
+  }
+  return false;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4String OutputParts::Next(G4long nofRows)
+{
+  ++fIndex;
+  fNofEvents = 0;
+  fFirstEvent = -1;
+  fLastEvent = -1;
+  fFirstRow = nofRows;
+
+  fName = fOutputName;
+  if (fRolling) {
+    if (fName.size() > 5 && fName.compare(fName.size() - 5, 5, ".root") == 0) {
+      fName.erase(fName.size() - 5);
+    }
+    char suffix[16];
+    std::snprintf(suffix, sizeof(suffix), "_part%03d", fIndex);
+    fName += suffix;
+  }
+  fFileName = RunManifest::GetPartName(fName);
+  return fName;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void OutputParts::DefineCommands()
+{
+  fMessenger = new G4GenericMessenger(this, "/mirage/output/roll/", "Output file rolling");
+
+  fMessenger->DeclareProperty("maxRows", fMaxRows)
+    .SetGuidance("Roll over to the next output file <name>_partNNN after this many")
+    .SetGuidance("neutrino rows of a thread; 0 for no limit. Multithreaded runs need")
+    .SetGuidance("/mirage/output/merge false.")
+    .SetParameterName("rows", false)
+    .SetRange("rows>=0")
+    .SetStates(G4State_PreInit, G4State_Idle);
+
+  fMessenger->DeclareProperty("maxSize", fMaxMegabytes)
+    .SetGuidance("Roll over to the next output file once the current one reaches this")
+    .SetGuidance("size in MB; 0 for no limit. The last event of a part may exceed it.")
+    .SetParameterName("megabytes", false)
+    .SetRange("megabytes>=0.")
+    .SetStates(G4State_PreInit, G4State_Idle);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}  // namespace mirage_horn
@@ -0,0 +1,131 @@
+/// \file mirage_horn/src/ParentStore.cc
+/// \brief Implementation of the mirage_horn::ParentStore class
+
+#include "ParentStore.hh"
+
+#include "G4GenericMessenger.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4Threading.hh"
+
+#include <cstring>
+
+namespace mirage_horn
+{
+
+namespace
+{
+  // records written to the file at a time
+  constexpr std::size_t kBufferSize = 4096;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+ParentStore::ParentStore()
+{
+  DefineCommands();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+ParentStore::~ParentStore()
+{
+  if (IsOpen()) Close(0);
+  delete fMessenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ParentStore::Open(const G4String& outputName, G4double worldHalfZ)
+{
+  if (IsOpen()) Close(0);
+
+  G4String fileName = outputName;
+  if (fileName.size() > 5 && fileName.compare(fileName.size() - 5, 5, ".root") == 0) {
+    fileName.erase(fileName.size() - 5);
+  }
+  fileName += ".parents";
+  if (G4Threading::IsWorkerThread()) {
+    fileName += "_t" + std::to_string(G4Threading::G4GetThreadId());
+  }
+  fileName += ".bin";
+
+  fFile.open(fileName, std::ios::binary | std::ios::trunc);
+  if (!fFile) {
+    G4ExceptionDescription msg;
+    msg << "Cannot open the parent store " << fileName << "; parents are not recorded.";
+    G4Exception("ParentStore::Open()", "MIRAGE007", JustWarning, msg);
+    return;
+  }
+
+  std::memset(&fHeader, 0, sizeof(fHeader));
+  std::memcpy(fHeader.magic, mirage::kParentFileMagic, sizeof(fHeader.magic));
+  fHeader.version = mirage::kParentFileVersion;
+  fHeader.recordSize = sizeof(mirage::ParentRecord);
+  fHeader.zOrigin = -worldHalfZ / m;
+
+  // header placeholder, rewritten by Close()
+  fFile.write(reinterpret_cast<const char*>(&fHeader), sizeof(fHeader));
+  fBuffer.reserve(kBufferSize);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ParentStore::Record(G4int pdg, const G4ThreeVector& momentum, G4double energy,
+                         const G4ThreeVector& position, G4double weight)
+{
+  mirage::ParentRecord record;
+  record.pdg = pdg;
+  record.reserved = 0;
+  record.px = momentum.x() / GeV;
+  record.py = momentum.y() / GeV;
+  record.pz = momentum.z() / GeV;
+  record.E = energy / GeV;
+  record.x = position.x() / m;
+  record.y = position.y() / m;
+  record.z = position.z() / m;
+  record.weight = weight;
+
+  fBuffer.push_back(record);
+  if (fBuffer.size() == kBufferSize) Flush();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ParentStore::Close(G4int nofEvents)
+{
+  if (!IsOpen()) return;
+
+  Flush();
+  fHeader.nofPOT = nofEvents;
+  fFile.seekp(0);
+  fFile.write(reinterpret_cast<const char*>(&fHeader), sizeof(fHeader));
+  fFile.close();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ParentStore::Flush()
+{
+  if (fBuffer.empty()) return;
+  fFile.write(reinterpret_cast<const char*>(fBuffer.data()),
+              fBuffer.size() * sizeof(mirage::ParentRecord));
+  fHeader.nofRecords += fBuffer.size();
+  fBuffer.clear();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ParentStore::DefineCommands()
+{
+  fMessenger = new G4GenericMessenger(this, "/mirage/parents/", "Parent-decay store control");
+
+  fMessenger->DeclareProperty("dump", fEnabled)
+    .SetGuidance("Write the pi+-, K+-, K0L and mu+- decays to <output>.parents*.bin")
+    .SetGuidance("for tools/redecay (takes effect at the next run).")
+    .SetParameterName("flag", true)
+    .SetDefaultValue("true");
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}  // namespace mirage_horn
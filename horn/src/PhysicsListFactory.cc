@@ -0,0 +1,65 @@
+/// \file mirage_horn/src/PhysicsListFactory.cc
+/// \brief Implementation of the mirage_horn::PhysicsListFactory class
+
+#include "PhysicsListFactory.hh"
+
+#include "SpecialCutsPhysics.hh"
+
+#include "FTFP_BERT.hh"
+#include "G4BuilderType.hh"
+#include "G4EmStandardPhysics_option1.hh"
+#include "G4GenericBiasingPhysics.hh"
+#include "G4NeutronTrackingCut.hh"
+#include "G4SystemOfUnits.hh"
+
+namespace mirage_horn
+{
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4VModularPhysicsList* PhysicsListFactory::Create(const G4String& tier, G4bool biasDecay)
+{
+  if (tier != "full" && tier != "flux" && tier != "fast") {
+    G4ExceptionDescription msg;
+    msg << "Unknown physics tier \"" << tier << "\" (full, flux or fast).";
+    G4Exception("PhysicsListFactory::Create()", "MIRAGE006", FatalException, msg);
+    return nullptr;
+  }
+
+  auto physicsList = new FTFP_BERT;
+
+  if (tier != "full") {
+    physicsList->ReplacePhysics(new G4EmStandardPhysics_option1());
+    physicsList->RemovePhysics(bEmExtra);
+
+    auto neutronCut = new G4NeutronTrackingCut();
+    neutronCut->SetKineticEnergyLimit(tier == "fast" ? 500. * MeV : 100. * MeV);
+    physicsList->RemovePhysics("neutronTrackingCut");
+    physicsList->RegisterPhysics(neutronCut);
+  }
+
+  if (tier == "fast") {
+    physicsList->RemovePhysics(bHadronElastic);
+    physicsList->RemovePhysics(bStopping);
+    physicsList->RemovePhysics(bIons);
+  }
+
+  // user limits of the regions (envelope kill volume, tracking floors)
+  physicsList->RegisterPhysics(new SpecialCutsPhysics);
+
+  // neutrino parents whose decay DecayBiasingOperator may bias
+  if (biasDecay) {
+    auto biasingPhysics = new G4GenericBiasingPhysics();
+    for (const char* particle : {"pi+", "pi-", "kaon+", "kaon-", "kaon0L"}) {
+      biasingPhysics->PhysicsBias(particle, {"Decay"});
+    }
+    physicsList->RegisterPhysics(biasingPhysics);
+  }
+
+  G4cout << "Physics tier: " << tier << (biasDecay ? " (decay biasing)" : "") << G4endl;
+  return physicsList;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}  // namespace mirage_horn
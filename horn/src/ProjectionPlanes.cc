@@ -0,0 +1,144 @@
+/// \file mirage_horn/src/ProjectionPlanes.cc
+/// \brief Implementation of the mirage_horn::ProjectionPlanes class
+
+#include "ProjectionPlanes.hh"
+
+#include "FluxWindow.hh"
+
+#include "G4GenericMessenger.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4UIcommand.hh"
+
+#include <sstream>
+
+namespace mirage_horn
+{
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+ProjectionPlanes::ProjectionPlanes()
+{
+  // the plane of the flux window, as before the plane list existed
+  fConfigs.push_back({"at574m", 0., 0., mirage::FluxWindow::kPlaneDistance, 0., 0., 1.});
+
+  DefineCommands();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+ProjectionPlanes::~ProjectionPlanes()
+{
+  delete fMessenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ProjectionPlanes::BookColumns(G4AnalysisManager* analysisManager) const
+{
+  for (const auto& name : GetColumnNames()) {
+    analysisManager->CreateNtupleDColumn(name);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+std::vector<G4String> ProjectionPlanes::GetColumnNames() const
+{
+  std::vector<G4String> names;
+  for (const auto& config : fConfigs) {
+    names.push_back("projX" + config.name);
+    names.push_back("projY" + config.name);
+  }
+  return names;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ProjectionPlanes::Build(G4double worldHalfZ)
+{
+  fPlanes.clear();
+  for (const auto& config : fConfigs) {
+    fPlanes.push_back(mirage::PlaneProjection::MakePlane(
+      config.x, config.y, config.distance - worldHalfZ / m, config.nx, config.ny, config.nz));
+  }
+  fNofProjected = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ProjectionPlanes::Project(const G4ThreeVector& decayPos, const G4double* px,
+                               const G4double* py, const G4double* pz, std::size_t n)
+{
+  fNofProjected = n;
+  if (fPlanes.empty()) return;
+
+  if (fProjections.size() < 2 * fPlanes.size() * n) {
+    fProjections.resize(2 * fPlanes.size() * n);
+  }
+  mirage::PlaneProjection::Project(fPlanes, decayPos.x() / m, decayPos.y() / m,
+                                   decayPos.z() / m, px, py, pz, n, fProjections.data());
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ProjectionPlanes::Fill(G4double* columns, std::size_t i) const
+{
+  // plane-major: u and v of plane k are rows 2k and 2k+1 of length n
+  for (std::size_t k = 0; k < fPlanes.size(); ++k) {
+    const G4double* u = fProjections.data() + 2 * k * fNofProjected;
+    columns[2 * k] = u[i];
+    columns[2 * k + 1] = u[fNofProjected + i];
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ProjectionPlanes::AddPlane(const G4String& args)
+{
+  std::istringstream is(args);
+  G4String name, unit = "m";
+  G4double x = 0., y = 0., distance = 0.;
+  if (!(is >> name >> x >> y >> distance)) {
+    G4ExceptionDescription msg;
+    msg << "Expected \"<name> <x> <y> <distance> [unit [nx ny nz]]\", got \"" << args << "\".";
+    G4Exception("ProjectionPlanes::AddPlane()", "MIRAGE009", JustWarning, msg);
+    return;
+  }
+  G4double nx = 0., ny = 0., nz = 1.;
+  if (is >> unit) {
+    is >> nx >> ny >> nz;
+  }
+
+  const G4double toMetre = G4UIcommand::ValueOf(unit.c_str()) / m;
+  fConfigs.push_back({name, x * toMetre, y * toMetre, distance * toMetre, nx, ny, nz});
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ProjectionPlanes::ClearPlanes()
+{
+  fConfigs.clear();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ProjectionPlanes::DefineCommands()
+{
+  fMessenger = new G4GenericMessenger(this, "/mirage/planes/", "Neutrino projection planes");
+
+  fMessenger->DeclareMethod("add", &ProjectionPlanes::AddPlane)
+    .SetGuidance("Add a projection plane: <name> <x> <y> <distance> [unit [nx ny nz]].")
+    .SetGuidance("Centre x and y in the world frame, distance from the upstream face of")
+    .SetGuidance("the world; the normal (nx, ny, nz) defaults to the beam axis.")
+    .SetGuidance("Adds the columns projX<name> and projY<name> to the mirage ntuple.")
+    .SetParameterName("plane", false)
+    .SetStates(G4State_PreInit, G4State_Idle);
+
+  fMessenger->DeclareMethod("clear", &ProjectionPlanes::ClearPlanes)
+    .SetGuidance("Remove all projection planes, including the default at574m.")
+    .SetStates(G4State_PreInit, G4State_Idle);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}  // namespace mirage_horn
@@ -31,14 +31,18 @@
 
 #include "DetectorConstruction.hh"
 #include "PrimaryGeneratorAction.hh"
+#include "RunManifest.hh"
+#include "SteppingBenchmark.hh"
 
 #include "G4AccumulableManager.hh"
+#include "G4GenericMessenger.hh"
 #include "G4LogicalVolume.hh"
 #include "G4ParticleDefinition.hh"
 #include "G4ParticleGun.hh"
 #include "G4Run.hh"
 #include "G4RunManager.hh"
 #include "G4SystemOfUnits.hh"
+#include "G4Threading.hh"
 #include "G4UnitsTable.hh"
 #include "G4Version.hh"
 #if G4VERSION_NUMBER >= 1100
@@ -47,6 +51,8 @@
   #include "g4root.hh"
 #endif
 
+#include <iomanip>
+
 namespace mirage_horn
 {
 
@@ -54,48 +60,122 @@ namespace mirage_horn
 
 RunAction::RunAction(G4String fileName)
   : G4UserRunAction(),
+    fFileName(fileName),
     fOutputName(fileName)
 {
+  // track kill counters filled by StackingAction
+  auto accumulableManager = G4AccumulableManager::Instance();
+  fNofKilled.reserve(kNofKillCategories);
+  for (G4int i = 0; i < kNofKillCategories; ++i) {
+    fNofKilled.emplace_back(G4long(0));
+  }
+  for (auto& counter : fNofKilled) {
+#if G4VERSION_NUMBER >= 1100
+    accumulableManager->Register(counter);
+#else
+    accumulableManager->RegisterAccumulable(counter);
+#endif
+  }
+
+  fMessenger = new G4GenericMessenger(this, "/mirage/stepping/", "Stepping action control");
+  fMessenger->DeclareProperty("benchmark", fBenchmarkIterations)
+    .SetGuidance("Time the per-step neutrino capture check at the start of each run.")
+    .SetGuidance("Argument is the number of iterations; 0 disables the benchmark.")
+    .SetParameterName("nIterations", false)
+    .SetDefaultValue("0");
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-void RunAction::BeginOfRunAction(const G4Run*)
+RunAction::~RunAction()
+{
+  delete fMessenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunAction::BeginOfRunAction(const G4Run* run)
 {
   // inform the runManager to save random number seed
   G4RunManager::GetRunManager()->SetRandomNumberStore(false);
 
+  // reset accumulables to their initial values
+  G4AccumulableManager::Instance()->Reset();
+  // a forked process (--fork) writes its own files
+  fOutputName = RunManifest::GetProcessName(fFileName);
+  fEventSeeds.BeginOfRun(run->GetNumberOfEventToBeProcessed());
+  if (IsMaster()) fEventSeeds.RunBenchmark();
+  fTimer.Start();
+  // the seed of the job, not that of the engine of this thread or process,
+  // which is reseeded for every event
+  fSeed = fEventSeeds.GetRunSeed();
+
   // analysis manager
   auto analysisManager = G4AnalysisManager::Instance();
   G4cout << "Using " << analysisManager->GetType() << G4endl;
 
-  analysisManager->SetNtupleMerging(true);
+  // rolling over needs a file per thread; the master file of a
+  // multithreaded run is not rolled
+  const G4bool multithreaded = G4Threading::IsMultithreadedApplication();
+  if (fOutputParts.IsRollingEnabled() && multithreaded && fOutputNtuples.IsMerging()
+      && IsMaster()) {
+    G4ExceptionDescription msg;
+    msg << "/mirage/output/roll needs /mirage/output/merge false in multithreaded mode;"
+        << " the output is not rolled over.";
+    G4Exception("RunAction::BeginOfRunAction()", "MIRAGE011", JustWarning, msg);
+  }
+  const G4bool rolling = fOutputParts.IsRollingEnabled()
+                         && (!multithreaded || (!IsMaster() && !fOutputNtuples.IsMerging()));
+
+  analysisManager->SetNtupleMerging(fOutputNtuples.IsMerging());
   analysisManager->SetVerboseLevel(1);
-  analysisManager->SetFileName(fOutputName);
+  analysisManager->SetFileName(fOutputParts.Begin(fOutputName, rolling));
+  fOutputNtuples.Configure(analysisManager);
   analysisManager->OpenFile();
-  analysisManager->CreateNtuple("mirage", "MIRAGE simulation TTree");
-  analysisManager->CreateNtupleIColumn("parentPDG");
-  analysisManager->CreateNtupleDColumn("parentPx");
-  analysisManager->CreateNtupleDColumn("parentPy");
-  analysisManager->CreateNtupleDColumn("parentPz");
-  analysisManager->CreateNtupleDColumn("parentE");
-  analysisManager->CreateNtupleDColumn("vertexX");
-  analysisManager->CreateNtupleDColumn("vertexY");
-  analysisManager->CreateNtupleDColumn("vertexZ");
-  analysisManager->CreateNtupleIColumn("daughterPDG");
-  analysisManager->CreateNtupleDColumn("daughterE");
-  analysisManager->CreateNtupleDColumn("daughterPx");
-  analysisManager->CreateNtupleDColumn("daughterPy");
-  analysisManager->CreateNtupleDColumn("daughterPz");
-  analysisManager->CreateNtupleDColumn("projXat574m");
-  analysisManager->CreateNtupleDColumn("projYat574m");
-  analysisManager->FinishNtuple();
+  fOutputNtuples.Book(analysisManager, fProjectionPlanes, fLocationWeights);
+  fOutputNtuples.BeginFile();
+  fAcceptanceFilter.BookNtuple(analysisManager);
+
+  // cache per-worker lookups for SteppingAction and StackingAction
+  fSteppingContext.Build();
+  fAcceptanceFilter.Build(fSteppingContext);
+  fProjectionPlanes.Build(fSteppingContext.GetWorldHalfZ());
+  fLocationWeights.Book(analysisManager, fSteppingContext.GetWorldHalfZ());
+  fFluxHistograms.Book(analysisManager, fOutputNtuples.GetExtraColumnNames());
+  fConvergenceMonitor.BeginOfRun(fOutputNtuples.GetExtraColumnNames(), IsMaster());
+
+  // neutrino rows of this thread; the culled ntuple is filled by tracking,
+  // so with it the writer stays on the tracking thread
+  if (!IsMaster() || !G4Threading::IsMultithreadedApplication()) {
+    if (fOutputNtuples.IsWritingFlux()) {
+      fFluxStore.Open(fOutputParts.GetName(), fOutputNtuples.GetExtraColumnNames());
+    }
+    fOutputWriter.Start(&fOutputNtuples, &fFluxStore, fAcceptanceFilter.HasNtuple());
+  }
+
+  // parent-decay store of this thread, for tools/redecay
+  if (fParentStore.IsEnabled() && (!IsMaster() || !G4Threading::IsMultithreadedApplication())) {
+    fParentStore.Open(fOutputName, fSteppingContext.GetWorldHalfZ());
+  }
+
+  if (fBenchmarkIterations > 0 && (!IsMaster() || !G4Threading::IsMultithreadedApplication())) {
+    SteppingBenchmark benchmark(&fSteppingContext);
+    benchmark.Run(fBenchmarkIterations);
+  }
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 void RunAction::EndOfRunAction(const G4Run* run)
 {
+  fTimer.Stop();
+  fConvergenceMonitor.EndOfRun();
+  fOutputWriter.Stop();
+  fParentStore.Close(run->GetNumberOfEvent());
+
+  // merge accumulables
+  G4AccumulableManager::Instance()->Merge();
+
   // print run summary
   G4int nofEvents = run->GetNumberOfEvent();
   if (nofEvents == 0) return;
@@ -111,11 +191,119 @@ void RunAction::EndOfRunAction(const G4Run* run)
       << "--------------------End of Local Run------------------------"
       << G4endl;
   }
+  PrintKillSummary(nofEvents);
+  if (IsMaster()) fConvergenceMonitor.PrintSummary(nofEvents);
+  fOutputWriter.PrintSummary(fTimer.GetRealElapsed());
+
+  // Without merging or with rolling the files of the threads are parts,
+  // listed in the manifest, each with the run row of its events. The run
+  // row of the master counts the events of all threads. The files of a
+  // forked process are parts of the job.
+  const G4bool multithreaded = G4Threading::IsMultithreadedApplication();
+  const G4bool parts = fOutputParts.IsRolling() || (!fOutputNtuples.IsMerging() && multithreaded)
+                       || RunManifest::GetProcess() >= 0;
+  const G4bool masterFile = IsMaster() && multithreaded;
 
   // save histograms & ntuple
+  G4Timer writeTimer;
+  writeTimer.Start();
+  if (parts && !masterFile) {
+    ClosePart();
+  }
+  else {
+    if (IsMaster()) FillRunRow(nofEvents, 0, nofEvents - 1);
+    auto analysisManager = G4AnalysisManager::Instance();
+    analysisManager->Write();
+    analysisManager->CloseFile();
+    fFluxStore.Close(nofEvents);
+  }
+  writeTimer.Stop();
+
+  // bytes per neutrino of the output files, for scripts/bench_output.sh
+  if (IsMaster()) {
+    std::vector<G4String> fileNames;
+    if (!parts || masterFile) fileNames.push_back(RunManifest::GetPartName(fOutputName));
+    if (parts) {
+      const auto partNames =
+        RunManifest::Write(fOutputName, fOutputNtuples.IsNormalised() ? "normalised" : "flat",
+                           fSeed, nofEvents, masterFile);
+      fileNames.insert(fileNames.end(), partNames.begin(), partNames.end());
+    }
+    fOutputNtuples.PrintSummary(fileNames, fTimer.GetRealElapsed(), writeTimer.GetRealElapsed());
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunAction::EndOfEvent(G4int eventID)
+{
+  // the current event is the last one; the run ends as usual
+  if (fConvergenceMonitor.EndOfEvent()) G4RunManager::GetRunManager()->AbortRun(true);
+
+  if (!fOutputParts.EndOfEvent(eventID, fOutputWriter.GetNofRows())) return;
+
+  // the rows of the part must be in its file before it is closed
+  fOutputWriter.Flush();
+  ClosePart();
+  G4AnalysisManager::Instance()->OpenFile(fOutputParts.Next(fOutputWriter.GetNofRows()));
+  fOutputNtuples.BeginFile();
+  if (fOutputNtuples.IsWritingFlux()) {
+    fFluxStore.Open(fOutputParts.GetName(), fOutputNtuples.GetExtraColumnNames());
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunAction::FillRunRow(G4int nofPOT, G4int firstEvent, G4int lastEvent)
+{
+  auto detector = static_cast<const DetectorConstruction*>(
+    G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+  fOutputNtuples.FillRun(nofPOT, fSeed, 0., detector->GetHornCurrent(), firstEvent, lastEvent);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunAction::ClosePart()
+{
+  FillRunRow(fOutputParts.GetNofEvents(), fOutputParts.GetFirstEvent(),
+             fOutputParts.GetLastEvent());
   auto analysisManager = G4AnalysisManager::Instance();
   analysisManager->Write();
   analysisManager->CloseFile();
+  fFluxStore.Close(fOutputParts.GetNofEvents());
+
+  const G4long nofRows = fOutputParts.GetNofRows(fOutputWriter.GetNofRows());
+  RunManifest::AddPart(fOutputParts.GetName(), fOutputParts.GetNofEvents(), nofRows,
+                       fOutputParts.GetFirstEvent(), fOutputParts.GetLastEvent());
+  if (fOutputParts.IsRolling()) {
+    G4cout << " Closed " << RunManifest::GetPartName(fOutputParts.GetName()) << ": "
+           << fOutputParts.GetNofEvents() << " POT (events " << fOutputParts.GetFirstEvent()
+           << "-" << fOutputParts.GetLastEvent() << "), " << nofRows << " neutrino rows"
+           << G4endl;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunAction::PrintKillSummary(G4int nofEvents) const
+{
+  static const char* names[kNofKillCategories] = {
+    "neutrino", "e+-/gamma", "mu+-", "neutron", "ion", "hadron", "species", "acceptance"
+  };
+
+  G4long nofKilled = 0;
+  for (const auto& counter : fNofKilled) nofKilled += counter.GetValue();
+
+  G4cout
+    << " POT: " << nofEvents
+    << "   real time: " << fTimer.GetRealElapsed() << " s"
+    << "   (" << 1000. * fTimer.GetRealElapsed() / nofEvents << " ms/POT)"
+    << G4endl
+    << " Tracks killed by stacking action: " << nofKilled
+    << " (" << static_cast<G4double>(nofKilled) / nofEvents << " /POT)" << G4endl;
+  for (G4int i = 0; i < kNofKillCategories; ++i) {
+    G4cout << "   " << std::setw(10) << names[i] << ": " << fNofKilled[i].GetValue() << G4endl;
+  }
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
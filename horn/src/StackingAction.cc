@@ -0,0 +1,137 @@
+/// \file mirage_horn/src/StackingAction.cc
+/// \brief Implementation of the mirage_horn::StackingAction class
+
+#include "StackingAction.hh"
+
+#include "AcceptanceFilter.hh"
+#include "RunAction.hh"
+#include "SteppingContext.hh"
+
+#include "G4GenericMessenger.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4Track.hh"
+
+namespace mirage_horn
+{
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+StackingAction::StackingAction(RunAction* runAction)
+  : G4UserStackingAction(),
+    fRunAction(runAction)
+{
+  DefineCommands();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+StackingAction::~StackingAction()
+{
+  delete fMessenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4ClassificationOfNewTrack StackingAction::ClassifyNewTrack(const G4Track* track)
+{
+  const G4int pdg = track->GetDefinition()->GetPDGEncoding();
+  const G4int absPDG = std::abs(pdg);
+
+  // already written out by SteppingAction at the decay step
+  if (SteppingContext::IsNeutrino(pdg)) {
+    if (!fKillNeutrinos) return fUrgent;
+    fRunAction->CountKilledTrack(kKilledNeutrino);
+    return fKill;
+  }
+
+  // never touch the beam protons
+  if (track->GetParentID() == 0) return fUrgent;
+
+  if (fOnlyNeutrinoParents &&
+      absPDG != 211 && absPDG != 321 && pdg != 130 && absPDG != 13) {
+    fRunAction->CountKilledTrack(kKilledSpecies);
+    return fKill;
+  }
+
+  G4double threshold = fHadronThreshold;
+  KillCategory category = kKilledHadron;
+  if (absPDG == 11 || pdg == 22) {
+    threshold = fEmThreshold;
+    category = kKilledEm;
+  }
+  else if (absPDG == 13) {
+    threshold = fMuonThreshold;
+    category = kKilledMuon;
+  }
+  else if (pdg == 2112) {
+    threshold = fNeutronThreshold;
+    category = kKilledNeutron;
+  }
+  else if (absPDG >= 1000000000) {
+    // nuclear fragments: d, t, alpha, ions (PDG 10LZZZAAAI)
+    threshold = fIonThreshold;
+    category = kKilledIon;
+  }
+
+  if (track->GetKineticEnergy() < threshold) {
+    fRunAction->CountKilledTrack(category);
+    return fKill;
+  }
+
+  const AcceptanceFilter* acceptance = fRunAction->GetAcceptanceFilter();
+  if (acceptance->IsEnabled() && AcceptanceFilter::IsCandidate(pdg) &&
+      !acceptance->CanReachWindow(track)) {
+    acceptance->RecordCulled(track);
+    fRunAction->CountKilledTrack(kKilledAcceptance);
+    return fKill;
+  }
+
+  return fUrgent;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void StackingAction::DefineCommands()
+{
+  fMessenger = new G4GenericMessenger(this, "/mirage/stack/", "Stacking action control");
+
+  fMessenger->DeclareProperty("killNeutrinos", fKillNeutrinos)
+    .SetGuidance("Kill neutrinos once SteppingAction has recorded them.")
+    .SetParameterName("flag", true)
+    .SetDefaultValue("true");
+
+  fMessenger->DeclareProperty("onlyNeutrinoParents", fOnlyNeutrinoParents)
+    .SetGuidance("Keep only pi+-, K+-, K0L and mu+- secondaries (primaries are always kept).")
+    .SetParameterName("flag", true)
+    .SetDefaultValue("true");
+
+  fMessenger->DeclarePropertyWithUnit("emThreshold", "MeV", fEmThreshold)
+    .SetGuidance("Kill e+-, gamma below this kinetic energy.")
+    .SetParameterName("ekin", false)
+    .SetRange("ekin>=0.");
+
+  fMessenger->DeclarePropertyWithUnit("muonThreshold", "MeV", fMuonThreshold)
+    .SetGuidance("Kill mu+- below this kinetic energy.")
+    .SetParameterName("ekin", false)
+    .SetRange("ekin>=0.");
+
+  fMessenger->DeclarePropertyWithUnit("neutronThreshold", "MeV", fNeutronThreshold)
+    .SetGuidance("Kill neutrons below this kinetic energy.")
+    .SetParameterName("ekin", false)
+    .SetRange("ekin>=0.");
+
+  fMessenger->DeclarePropertyWithUnit("ionThreshold", "MeV", fIonThreshold)
+    .SetGuidance("Kill nuclear fragments (d, t, alpha, ions) below this kinetic energy.")
+    .SetParameterName("ekin", false)
+    .SetRange("ekin>=0.");
+
+  fMessenger->DeclarePropertyWithUnit("hadronThreshold", "MeV", fHadronThreshold)
+    .SetGuidance("Kill all other hadrons (p, pi, K, ...) below this kinetic energy.")
+    .SetParameterName("ekin", false)
+    .SetRange("ekin>=0.");
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}  // namespace mirage_horn
@@ -29,104 +29,122 @@
 
 #include "SteppingAction.hh"
 
+#include "ConvergenceMonitor.hh"
 #include "DetectorConstruction.hh"
 #include "EventAction.hh"
+#include "FluxHistograms.hh"
+#include "LocationWeights.hh"
+#include "OutputBuffer.hh"
+#include "ParentStore.hh"
+#include "ProjectionPlanes.hh"
+#include "SteppingContext.hh"
 
-#include "G4Event.hh"
-#include "G4LogicalVolume.hh"
-#include "G4RunManager.hh"
 #include "G4Step.hh"
-
-#include "G4TransportationManager.hh"
-#include "G4Box.hh"
-
-#include "G4PionPlus.hh"
-#include "G4PionMinus.hh"
-#include "G4KaonPlus.hh"
-#include "G4KaonMinus.hh"
-
-#include "G4Version.hh"
-#if G4VERSION_NUMBER >= 1100
-    #include "G4AnalysisManager.hh"
-#else
-    #include "g4root.hh"
-#endif
+#include "G4SystemOfUnits.hh"
+#include "G4Track.hh"
 
 namespace mirage_horn
 {
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-SteppingAction::SteppingAction(EventAction* eventAction) : fEventAction(eventAction) {}
+SteppingAction::SteppingAction(EventAction* eventAction, const SteppingContext* context,
+                               ParentStore* parentStore, const LocationWeights* locationWeights,
+                               ProjectionPlanes* projectionPlanes,
+                               const FluxHistograms* fluxHistograms,
+                               ConvergenceMonitor* convergenceMonitor)
+    : fEventAction(eventAction),
+      fContext(context),
+      fParentStore(parentStore),
+      fLocationWeights(locationWeights),
+      fProjectionPlanes(projectionPlanes),
+      fFluxHistograms(fluxHistograms),
+      fConvergenceMonitor(convergenceMonitor)
+{}
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 void SteppingAction::UserSteppingAction(const G4Step* step)
 {
-    auto analysisManager = G4AnalysisManager::Instance();
+    // Find out parent particle that produces neutrinos.
+    // Everything looked up here is cached per worker in SteppingContext,
+    // so non-decay steps cost one pointer compare per decay process.
+    if( !fContext->IsDecay(step->GetPostStepPoint()->GetProcessDefinedStep()) ) return;
+
     G4Track* track = step->GetTrack();
+    const std::vector<const G4Track*>* secondaries = step->GetSecondaryInCurrentStep();
+
+    // Parent particle info
+    G4int parentPDG = track->GetDefinition()->GetPDGEncoding();
+    G4ThreeVector parentMom = track->GetMomentum();
+    G4double parentE = track->GetTotalEnergy();
+    G4ThreeVector decayPos = track->GetPosition();
+
+    // for re-decaying offline (tools/redecay)
+    if( fParentStore->IsOpen() && mirage::DecayKinematics::CanDecay(parentPDG) ) {
+        fParentStore->Record(parentPDG, parentMom, parentE, decayPos, track->GetWeight());
+    }
+
+    // With decay multiplexing this decay is one of K+1 of the same parent
+    const G4bool multiplex = fMultiplexer.Applies(parentPDG);
+    const G4double share = multiplex ? 1.0/(fMultiplexer.GetNofDecays() + 1) : 1.0;
+
+    // Neutrinos of this decay (GeV), projected onto the planes together
+    fNeutrinos.resize(0);
+    fWeights.clear();
+    for( size_t i = 0; i < secondaries->size(); ++i ) {
+        const G4Track* secTrack = (*secondaries)[i];
+        G4int secPDG = secTrack->GetDefinition()->GetPDGEncoding();
+        if( !SteppingContext::IsNeutrino(secPDG) ) continue;
+
+        const G4ThreeVector& nuMom = secTrack->GetMomentum();
+        fNeutrinos.push_back(secPDG, secTrack->GetTotalEnergy()/CLHEP::GeV,
+                             nuMom.x()/CLHEP::GeV, nuMom.y()/CLHEP::GeV, nuMom.z()/CLHEP::GeV);
+        // importance weight (1 unless the decay was biased, see DecayBiasingOperator)
+        fWeights.push_back(secTrack->GetWeight() * share);
+    }
 
-    G4StepPoint* postPoint = step->GetPostStepPoint();
-
-    G4VPhysicalVolume* worldPV = G4TransportationManager::GetTransportationManager()
-                                    ->GetNavigatorForTracking()
-                                    ->GetWorldVolume();
-    G4Box* worldBox = dynamic_cast<G4Box*>(worldPV->GetLogicalVolume()->GetSolid());
-    G4double worldHalfZ = worldBox->GetZHalfLength();
-
-    // Find out parent particle that produces neutrinos
-    if( postPoint->GetProcessDefinedStep() &&
-        postPoint->GetProcessDefinedStep()->GetProcessName() == "Decay" )
-    {
-        const std::vector<const G4Track*>* secondaries = step->GetSecondaryInCurrentStep();
-
-        // Parent particle info
-        G4int parentPDG = track->GetDefinition()->GetPDGEncoding();
-        G4ThreeVector parentMom = track->GetMomentum();
-        G4double parentE = track->GetTotalEnergy();
-        G4ThreeVector decayPos = track->GetPosition();
-
-        for( size_t i = 0; i < secondaries->size(); ++i ) {
-            const G4Track* secTrack = (*secondaries)[i];
-            G4int secPDG = secTrack->GetDefinition()->GetPDGEncoding();
-            G4String partName = secTrack->GetDefinition()->GetParticleName();
-
-            //if( G4StrUtil::contains(partName, "nu") || G4StrUtil::contains(partName,"anti_nu") ) {
-            if( partName.contains("nu") || partName.contains("anti_nu") ) {
-            G4ThreeVector nuMom = secTrack->GetMomentum();
-            G4double x_proj = -9999.0 * CLHEP::m;
-            G4double y_proj = -9999.0 * CLHEP::m;
-
-            // Calculate projection at 574 m
-            if( nuMom.getZ() > 0.0) {
-                G4double z_target = (574.0 - worldHalfZ) * CLHEP::m;
-                G4double deltaZ = z_target - decayPos.z();
-                x_proj = decayPos.x() + nuMom.getX()/nuMom.getZ() * deltaZ;
-                y_proj = decayPos.y() + nuMom.getY()/nuMom.getZ() * deltaZ;
-            }
-
-            // Fill ntuple
-            // parent particle info
-            analysisManager->FillNtupleIColumn(0, parentPDG);
-            analysisManager->FillNtupleDColumn(1, parentMom.getX()/CLHEP::GeV);
-            analysisManager->FillNtupleDColumn(2, parentMom.getY()/CLHEP::GeV);
-            analysisManager->FillNtupleDColumn(3, parentMom.getZ()/CLHEP::GeV);
-            analysisManager->FillNtupleDColumn(4, parentE/CLHEP::GeV);
-            analysisManager->FillNtupleDColumn(5, decayPos.getX()/CLHEP::m);
-            analysisManager->FillNtupleDColumn(6, decayPos.getY()/CLHEP::m);
-            analysisManager->FillNtupleDColumn(7, decayPos.getZ()/CLHEP::m);
-            // neutrino info
-            analysisManager->FillNtupleIColumn(8, secPDG);
-            analysisManager->FillNtupleDColumn(9, secTrack->GetTotalEnergy()/CLHEP::GeV);
-            analysisManager->FillNtupleDColumn(10, nuMom.getX()/CLHEP::GeV);
-            analysisManager->FillNtupleDColumn(11, nuMom.getY()/CLHEP::GeV);
-            analysisManager->FillNtupleDColumn(12, nuMom.getZ()/CLHEP::GeV);
-            analysisManager->FillNtupleDColumn(13, x_proj/CLHEP::m);
-            analysisManager->FillNtupleDColumn(14, y_proj/CLHEP::m);
-            analysisManager->AddNtupleRow();
-            }
+    if( multiplex ) {
+        // K analytic decays of the same parent; the parent carries the weight
+        // its decay products got from Geant4
+        const auto& batch = fMultiplexer.Sample(parentPDG, parentMom);
+        const G4double weight = track->GetWeight() * share;
+        for( size_t i = 0; i < batch.size(); ++i ) {
+            fNeutrinos.push_back(batch.pdg[i], batch.E[i], batch.px[i], batch.py[i], batch.pz[i]);
+            fWeights.push_back(weight);
         }
     }
+
+    if( fNeutrinos.size() == 0 ) return;
+    fProjectionPlanes->Project(decayPos, fNeutrinos.px.data(), fNeutrinos.py.data(),
+                               fNeutrinos.pz.data(), fNeutrinos.size());
+    OutputBuffer* buffer = fEventAction->BeginDecay(parentPDG, parentMom, parentE, decayPos,
+                                                    fNeutrinos.size());
+    for( size_t i = 0; i < fNeutrinos.size(); ++i ) {
+        FillRow(buffer, parentMom, parentE, decayPos, i);
+    }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void SteppingAction::FillRow(OutputBuffer* buffer, const G4ThreeVector& parentMom,
+                             G4double parentE, const G4ThreeVector& decayPos, size_t i) const
+{
+    // neutrino columns, see OutputNtuples
+    G4double* columns = buffer->AddNeutrino(fNeutrinos.pdg[i], fNeutrinos.E[i], fNeutrinos.px[i],
+                                            fNeutrinos.py[i], fNeutrinos.pz[i], fWeights[i]);
+    // projection planes, then detector locations
+    fProjectionPlanes->Fill(columns, i);
+    const G4ThreeVector nuMom(fNeutrinos.px[i], fNeutrinos.py[i], fNeutrinos.pz[i]);
+    G4double* locationColumns = columns + fProjectionPlanes->GetNofColumns();
+    fLocationWeights->Fill(fContext->GetAnalysisManager(), locationColumns,
+                           parentMom, parentE, decayPos, fNeutrinos.pdg[i], nuMom*CLHEP::GeV,
+                           fNeutrinos.E[i]*CLHEP::GeV, fWeights[i]);
+    fFluxHistograms->Fill(fContext->GetAnalysisManager(), fNeutrinos.pdg[i], fNeutrinos.E[i],
+                          fNeutrinos.px[i], fNeutrinos.py[i], fNeutrinos.pz[i], fWeights[i],
+                          columns);
+    fConvergenceMonitor->Fill(fNeutrinos.pdg[i], fNeutrinos.E[i], fNeutrinos.pz[i], fWeights[i],
+                              columns);
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
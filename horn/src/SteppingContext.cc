@@ -0,0 +1,65 @@
+/// \file mirage_horn/src/SteppingContext.cc
+/// \brief Implementation of the mirage_horn::SteppingContext class
+
+#include "SteppingContext.hh"
+
+#include "FluxWindow.hh"
+
+#include "G4Box.hh"
+#include "G4LogicalVolume.hh"
+#include "G4ProcessTable.hh"
+#include "G4ProcessVector.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4TransportationManager.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4VProcess.hh"
+
+namespace mirage_horn
+{
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void SteppingContext::Build()
+{
+  fAnalysisManager = G4AnalysisManager::Instance();
+
+  G4VPhysicalVolume* worldPV = G4TransportationManager::GetTransportationManager()
+                                  ->GetNavigatorForTracking()
+                                  ->GetWorldVolume();
+  auto worldBox = dynamic_cast<G4Box*>(worldPV->GetLogicalVolume()->GetSolid());
+  fWorldHalfZ = worldBox->GetZHalfLength();
+
+  // Near detector plane, measured from the upstream face of the world
+  fProjectionPlaneZ = mirage::FluxWindow::kPlaneDistance * m - fWorldHalfZ;
+
+  // The process table is thread-local, so these are this worker's instances.
+  // With --bias-decay the decay of the biased species is wrapped, and the
+  // wrapper is the process that defines the decay step.
+  fNofDecayProcesses = 0;
+  for (const char* name : {"Decay", "biasWrapper(Decay)"}) {
+    G4ProcessVector* decays = G4ProcessTable::GetProcessTable()->FindProcesses(name);
+    for (std::size_t i = 0; i < decays->size(); ++i) {
+      const G4VProcess* process = (*decays)[i];
+      G4bool known = false;
+      for (G4int j = 0; j < fNofDecayProcesses; ++j) {
+        if (fDecayProcesses[j] == process) known = true;
+      }
+      if (known) continue;
+      if (fNofDecayProcesses == kMaxDecayProcesses) {
+        G4Exception("SteppingContext::Build()", "MIRAGE001", FatalException,
+                    "Too many distinct \"Decay\" process instances.");
+      }
+      fDecayProcesses[fNofDecayProcesses++] = process;
+    }
+    delete decays;
+  }
+
+  if (fNofDecayProcesses == 0) {
+    G4Exception("SteppingContext::Build()", "MIRAGE002", JustWarning,
+                "No \"Decay\" process found; no neutrinos will be recorded.");
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}  // namespace mirage_horn
@@ -0,0 +1,272 @@
+/// \file tools/fluxscan.cc
+/// \brief Neutrino spectra from the columnar flux files
+
+// Reads one or more columnar flux files (/mirage/output/backend flux) in
+// place with mirage::FluxReader and prints the neutrino spectra, per POT,
+// through the window on one of the projection planes of the simulation.
+// The blocks whose zone map rules out the flavours, the window or the
+// energy range are skipped unread. No Geant4 and no ROOT.
+//
+//   ./fluxscan [options] output_t0.flux [output_t1.flux ...]
+//
+// Run ./fluxscan --help for the options.
+
+#include "FluxReader.hh"
+#include "FluxWindow.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+struct Options
+{
+  std::string plane = "at574m";  // name of the projection plane
+  double halfWidthX = mirage::FluxWindow::kHalfWidthX;
+  double halfWidthY = mirage::FluxWindow::kHalfWidthY;
+  double centerX = 0.;
+  double centerY = 0.;
+  int nofBins = 40;
+  double maxEnergy = 20.;  // GeV
+  std::uint32_t flavours = 0;  // FluxFlavour bits, 0 for all
+  bool list = false;
+  std::string output;
+  std::vector<std::string> inputs;
+};
+
+// numu, numubar, nue, nuebar
+constexpr int kNofFlavours = 4;
+const int kFlavours[kNofFlavours] = {14, -14, 12, -12};
+const char* kFlavourNames[kNofFlavours] = {"numu", "numubar", "nue", "nuebar"};
+const std::uint32_t kFlavourBits[kNofFlavours] = {mirage::kFluxNuMu, mirage::kFluxNuMuBar,
+                                                 mirage::kFluxNuE, mirage::kFluxNuEBar};
+
+int FlavourIndex(int pdg)
+{
+  for (int i = 0; i < kNofFlavours; ++i) {
+    if (kFlavours[i] == pdg) return i;
+  }
+  return -1;
+}
+
+void PrintUsage(const char* name)
+{
+  std::printf(
+    "Usage: %s [options] file.flux [file.flux ...]\n"
+    "  -p, --plane NAME       projection plane, as in projX<NAME> (default at574m)\n"
+    "  -w, --window HX HY     window half-widths [m] (default %g %g)\n"
+    "  -c, --center X Y       window centre [m] (default 0 0)\n"
+    "  -b, --bins N           energy bins (default 40)\n"
+    "  -e, --emax E           upper edge of the energy axis [GeV] (default 20)\n"
+    "  -f, --flavour NAME     only numu, numubar, nue or nuebar; repeatable (default all)\n"
+    "  -l, --list             list the columns and blocks of the files\n"
+    "  -o, --output FILE      write the spectra to FILE instead of stdout\n",
+    name, mirage::FluxWindow::kHalfWidthX, mirage::FluxWindow::kHalfWidthY);
+}
+
+bool ParseOptions(int argc, char** argv, Options& options)
+{
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    auto value = [&](int k) -> const char* {
+      if (i + k >= argc) {
+        std::fprintf(stderr, "fluxscan: %s needs %d value(s)\n", arg.c_str(), k);
+        std::exit(1);
+      }
+      return argv[i + k];
+    };
+    if (arg == "-h" || arg == "--help") {
+      PrintUsage(argv[0]);
+      std::exit(0);
+    }
+    else if (arg == "-p" || arg == "--plane") {
+      options.plane = value(1);
+      i += 1;
+    }
+    else if (arg == "-w" || arg == "--window") {
+      options.halfWidthX = std::atof(value(1));
+      options.halfWidthY = std::atof(value(2));
+      i += 2;
+    }
+    else if (arg == "-c" || arg == "--center") {
+      options.centerX = std::atof(value(1));
+      options.centerY = std::atof(value(2));
+      i += 2;
+    }
+    else if (arg == "-b" || arg == "--bins") {
+      options.nofBins = std::atoi(value(1));
+      i += 1;
+    }
+    else if (arg == "-e" || arg == "--emax") {
+      options.maxEnergy = std::atof(value(1));
+      i += 1;
+    }
+    else if (arg == "-f" || arg == "--flavour") {
+      const std::string name = value(1);
+      int f = 0;
+      while (f < kNofFlavours && name != kFlavourNames[f]) ++f;
+      if (f == kNofFlavours) {
+        std::fprintf(stderr, "fluxscan: unknown flavour %s\n", name.c_str());
+        return false;
+      }
+      options.flavours |= kFlavourBits[f];
+      i += 1;
+    }
+    else if (arg == "-l" || arg == "--list") {
+      options.list = true;
+    }
+    else if (arg == "-o" || arg == "--output") {
+      options.output = value(1);
+      i += 1;
+    }
+    else if (!arg.empty() && arg[0] == '-') {
+      std::fprintf(stderr, "fluxscan: unknown option %s\n", arg.c_str());
+      return false;
+    }
+    else {
+      options.inputs.push_back(arg);
+    }
+  }
+
+  if (options.inputs.empty() || options.nofBins <= 0 || options.maxEnergy <= 0. ||
+      options.halfWidthX <= 0. || options.halfWidthY <= 0.) {
+    PrintUsage(argv[0]);
+    return false;
+  }
+  return true;
+}
+
+void ListFile(const std::string& fileName, const mirage::FluxReader& reader)
+{
+  std::printf("%s: %llu rows in %zu blocks, %llu POT, %zu bytes\n", fileName.c_str(),
+              (unsigned long long)reader.GetNofRows(), reader.GetNofBlocks(),
+              (unsigned long long)reader.GetNofPOT(), reader.GetFileSize());
+  // ranges over the whole file from the zone map
+  for (std::size_t c = 0; c < reader.GetNofColumns(); ++c) {
+    const auto& column = reader.GetColumn(c);
+    double min = 0., max = 0.;
+    for (std::size_t b = 0; b < reader.GetNofBlocks(); ++b) {
+      const auto& stats = reader.GetStats(b, static_cast<int>(c));
+      min = b == 0 ? stats.min : std::min(min, stats.min);
+      max = b == 0 ? stats.max : std::max(max, stats.max);
+    }
+    std::printf("  %-24s %-8s %12.5g %12.5g\n", column.name,
+                column.type == mirage::kFluxInt32 ? "int32" : "float64", min, max);
+  }
+}
+
+}  // namespace
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+int main(int argc, char** argv)
+{
+  Options options;
+  if (!ParseOptions(argc, argv, options)) return 1;
+
+  auto start = std::chrono::steady_clock::now();
+
+  // weighted spectra, [flavour][bin]
+  std::vector<double> spectra(kNofFlavours * options.nofBins, 0.);
+  const double binsPerGeV = options.nofBins / options.maxEnergy;
+  const std::uint32_t flavours = options.flavours ? options.flavours : mirage::kFluxNuMu |
+    mirage::kFluxNuMuBar | mirage::kFluxNuE | mirage::kFluxNuEBar;
+  std::uint64_t nofPOT = 0, nofRows = 0, nofBytes = 0, nofBytesRead = 0;
+  std::size_t nofBlocks = 0, nofBlocksRead = 0;
+
+  for (const auto& input : options.inputs) {
+    mirage::FluxReader reader(input);
+    if (!reader.IsOpen()) {
+      std::fprintf(stderr, "fluxscan: %s\n", reader.GetError().c_str());
+      return 1;
+    }
+    if (options.list) ListFile(input, reader);
+
+    const int pdgColumn = reader.FindColumn("daughterPDG");
+    const int energyColumn = reader.FindColumn("daughterE");
+    const int weightColumn = reader.FindColumn("weight");
+    const int xColumn = reader.FindColumn("projX" + options.plane);
+    const int yColumn = reader.FindColumn("projY" + options.plane);
+    if (pdgColumn < 0 || energyColumn < 0 || weightColumn < 0 || xColumn < 0 || yColumn < 0) {
+      std::fprintf(stderr, "fluxscan: %s has no projection plane %s\n", input.c_str(),
+                   options.plane.c_str());
+      return 1;
+    }
+    nofPOT += reader.GetNofPOT();
+    nofRows += reader.GetNofRows();
+    nofBytes += reader.GetFileSize();
+    nofBlocks += reader.GetNofBlocks();
+
+    const int columns[] = {pdgColumn, energyColumn, weightColumn, xColumn, yColumn};
+    for (std::size_t b = 0; b < reader.GetNofBlocks(); ++b) {
+      if (!(reader.GetFlavours(b) & flavours) ||
+          !reader.MayContain(b, energyColumn, 0., options.maxEnergy) ||
+          !reader.MayContain(b, xColumn, options.centerX - options.halfWidthX,
+                             options.centerX + options.halfWidthX) ||
+          !reader.MayContain(b, yColumn, options.centerY - options.halfWidthY,
+                             options.centerY + options.halfWidthY)) continue;
+      ++nofBlocksRead;
+      for (int column : columns) nofBytesRead += reader.GetColumnSize(b, column);
+
+      const auto pdg = reader.Get<std::int32_t>(b, pdgColumn);
+      const auto energy = reader.Get<double>(b, energyColumn);
+      const auto weight = reader.Get<double>(b, weightColumn);
+      const auto x = reader.Get<double>(b, xColumn);
+      const auto y = reader.Get<double>(b, yColumn);
+      for (std::size_t r = 0; r < energy.size(); ++r) {
+        if (std::abs(x[r] - options.centerX) >= options.halfWidthX ||
+            std::abs(y[r] - options.centerY) >= options.halfWidthY) continue;
+        const int bin = static_cast<int>(energy[r] * binsPerGeV);
+        const int flavour = FlavourIndex(pdg[r]);
+        if (bin >= options.nofBins || flavour < 0 || !(kFlavourBits[flavour] & flavours)) continue;
+        spectra[flavour * options.nofBins + bin] += weight[r];
+      }
+    }
+  }
+
+  const double seconds =
+    std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  FILE* out = stdout;
+  if (!options.output.empty()) {
+    out = std::fopen(options.output.c_str(), "w");
+    if (!out) {
+      std::perror(options.output.c_str());
+      return 1;
+    }
+  }
+
+  // per POT when the files know it
+  const double norm = nofPOT > 0 ? 1. / nofPOT : 1.;
+  std::fprintf(out, "# rows: %llu  POT: %llu\n",
+               (unsigned long long)nofRows, (unsigned long long)nofPOT);
+  std::fprintf(out, "# plane: %s  window: |x - %g| < %g m, |y - %g| < %g m\n",
+               options.plane.c_str(), options.centerX, options.halfWidthX,
+               options.centerY, options.halfWidthY);
+  std::fprintf(out, "# neutrinos in the window per POT per bin\n");
+  std::fprintf(out, "# Emin[GeV] Emax[GeV]");
+  for (int f = 0; f < kNofFlavours; ++f) std::fprintf(out, " %12s", kFlavourNames[f]);
+  std::fprintf(out, "\n");
+  const double binWidth = options.maxEnergy / options.nofBins;
+  for (int bin = 0; bin < options.nofBins; ++bin) {
+    std::fprintf(out, "%10.4g %10.4g", bin * binWidth, (bin + 1) * binWidth);
+    for (int f = 0; f < kNofFlavours; ++f) {
+      std::fprintf(out, " %12.5e", spectra[f * options.nofBins + bin] * norm);
+    }
+    std::fprintf(out, "\n");
+  }
+  if (out != stdout) std::fclose(out);
+
+  std::fprintf(stderr, "fluxscan: %llu rows in %.3f s, %zu of %zu blocks read, "
+               "%.2f of %.2f MB (%.1f MB/s)\n",
+               (unsigned long long)nofRows, seconds, nofBlocksRead, nofBlocks,
+               nofBytesRead / 1e6, nofBytes / 1e6,
+               seconds > 0. ? nofBytesRead / seconds / 1e6 : 0.);
+  return 0;
+}
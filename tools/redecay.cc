@@ -0,0 +1,330 @@
+/// \file tools/redecay.cc
+/// \brief Offline re-decay of the parent-decay store
+
+// Re-decays every pi+-, K+-, K0L and mu+- of one or more parent-decay stores
+// (/mirage/parents/dump) N times with mirage::DecayKinematics and prints the
+// neutrino spectra, per POT, through a window on a plane at any distance.
+// Stores of version 1 have no mu+- decays: their spectra are flagged as
+// partial, as the nue, nuebar and part of the numu, numubar are missing.
+// No Geant4 and no ROOT: the stores are memory-mapped and read in place.
+//
+//   ./redecay [options] output.parents_t0.bin [output.parents_t1.bin ...]
+//
+// Run ./redecay --help for the options.
+
+#include "DecayKinematics.hh"
+#include "FluxWindow.hh"
+#include "ParentRecord.hh"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+struct Options
+{
+  int nofDecays = 100;
+  double plane = mirage::FluxWindow::kPlaneDistance;  // m from the upstream face
+  double halfWidthX = mirage::FluxWindow::kHalfWidthX;
+  double halfWidthY = mirage::FluxWindow::kHalfWidthY;
+  double centerX = 0.;
+  double centerY = 0.;
+  int nofBins = 40;
+  double maxEnergy = 20.;  // GeV
+  unsigned long seed = 1234;
+  unsigned nofThreads = std::thread::hardware_concurrency();
+  std::string output;
+  std::vector<std::string> inputs;
+};
+
+// read-only memory map of one store
+struct MappedStore
+{
+  void* address = MAP_FAILED;
+  std::size_t length = 0;
+  const mirage::ParentFileHeader* header = nullptr;
+  const mirage::ParentRecord* records = nullptr;
+};
+
+// numu, numubar, nue, nuebar
+constexpr int kNofFlavours = 4;
+const int kFlavours[kNofFlavours] = {14, -14, 12, -12};
+const char* kFlavourNames[kNofFlavours] = {"numu", "numubar", "nue", "nuebar"};
+
+int FlavourIndex(int pdg)
+{
+  for (int i = 0; i < kNofFlavours; ++i) {
+    if (kFlavours[i] == pdg) return i;
+  }
+  return -1;
+}
+
+void PrintUsage(const char* name)
+{
+  std::printf(
+    "Usage: %s [options] store.bin [store.bin ...]\n"
+    "  -n, --decays N         decays per parent (default 100)\n"
+    "  -p, --plane D          plane distance from the upstream face of the world [m] (default %g)\n"
+    "  -w, --window HX HY     window half-widths [m] (default %g %g)\n"
+    "  -c, --center X Y       window centre [m] (default 0 0)\n"
+    "  -b, --bins N           energy bins (default 40)\n"
+    "  -e, --emax E           upper edge of the energy axis [GeV] (default 20)\n"
+    "  -s, --seed S           random seed (default 1234)\n"
+    "  -j, --threads N        threads (default: all cores)\n"
+    "  -o, --output FILE      write the spectra to FILE instead of stdout\n",
+    name, mirage::FluxWindow::kPlaneDistance,
+    mirage::FluxWindow::kHalfWidthX, mirage::FluxWindow::kHalfWidthY);
+}
+
+bool ParseOptions(int argc, char** argv, Options& options)
+{
+  // signed, so that a negative count is rejected instead of wrapping
+  int nofThreads = static_cast<int>(options.nofThreads);
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    auto value = [&](int k) -> const char* {
+      if (i + k >= argc) {
+        std::fprintf(stderr, "redecay: %s needs %d value(s)\n", arg.c_str(), k);
+        std::exit(1);
+      }
+      return argv[i + k];
+    };
+    if (arg == "-h" || arg == "--help") {
+      PrintUsage(argv[0]);
+      std::exit(0);
+    }
+    else if (arg == "-n" || arg == "--decays") {
+      options.nofDecays = std::atoi(value(1));
+      i += 1;
+    }
+    else if (arg == "-p" || arg == "--plane") {
+      options.plane = std::atof(value(1));
+      i += 1;
+    }
+    else if (arg == "-w" || arg == "--window") {
+      options.halfWidthX = std::atof(value(1));
+      options.halfWidthY = std::atof(value(2));
+      i += 2;
+    }
+    else if (arg == "-c" || arg == "--center") {
+      options.centerX = std::atof(value(1));
+      options.centerY = std::atof(value(2));
+      i += 2;
+    }
+    else if (arg == "-b" || arg == "--bins") {
+      options.nofBins = std::atoi(value(1));
+      i += 1;
+    }
+    else if (arg == "-e" || arg == "--emax") {
+      options.maxEnergy = std::atof(value(1));
+      i += 1;
+    }
+    else if (arg == "-s" || arg == "--seed") {
+      options.seed = std::strtoul(value(1), nullptr, 10);
+      i += 1;
+    }
+    else if (arg == "-j" || arg == "--threads") {
+      nofThreads = std::atoi(value(1));
+      i += 1;
+    }
+    else if (arg == "-o" || arg == "--output") {
+      options.output = value(1);
+      i += 1;
+    }
+    else if (!arg.empty() && arg[0] == '-') {
+      std::fprintf(stderr, "redecay: unknown option %s\n", arg.c_str());
+      return false;
+    }
+    else {
+      options.inputs.push_back(arg);
+    }
+  }
+
+  if (options.inputs.empty() || options.nofDecays <= 0 || options.nofBins <= 0 || nofThreads < 0 ||
+      options.maxEnergy <= 0. || options.halfWidthX <= 0. || options.halfWidthY <= 0.) {
+    PrintUsage(argv[0]);
+    return false;
+  }
+  options.nofThreads = nofThreads > 0 ? static_cast<unsigned>(nofThreads) : 1;
+  return true;
+}
+
+bool MapStore(const std::string& fileName, MappedStore& store)
+{
+  const int fd = open(fileName.c_str(), O_RDONLY);
+  if (fd < 0) {
+    std::perror(fileName.c_str());
+    return false;
+  }
+  struct stat status;
+  if (fstat(fd, &status) != 0 || status.st_size < (off_t)sizeof(mirage::ParentFileHeader)) {
+    std::fprintf(stderr, "redecay: %s is not a parent store\n", fileName.c_str());
+    close(fd);
+    return false;
+  }
+  store.length = status.st_size;
+  store.address = mmap(nullptr, store.length, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (store.address == MAP_FAILED) {
+    std::perror(fileName.c_str());
+    return false;
+  }
+  madvise(store.address, store.length, MADV_SEQUENTIAL);
+
+  store.header = static_cast<const mirage::ParentFileHeader*>(store.address);
+  const std::size_t nofRecords = store.header->nofRecords;
+  if (!store.header->IsValid() || store.header->recordSize != sizeof(mirage::ParentRecord) ||
+      store.length < sizeof(mirage::ParentFileHeader) + nofRecords * sizeof(mirage::ParentRecord)) {
+    std::fprintf(stderr, "redecay: %s is not a complete parent store (version %u)\n",
+                 fileName.c_str(), store.header->version);
+    munmap(store.address, store.length);
+    store.address = MAP_FAILED;
+    return false;
+  }
+  store.records = reinterpret_cast<const mirage::ParentRecord*>(
+    static_cast<const char*>(store.address) + sizeof(mirage::ParentFileHeader));
+  return true;
+}
+
+// weighted spectra of one thread, [flavour][bin]
+using Spectra = std::vector<double>;
+
+void Redecay(const Options& options, const MappedStore& store, std::size_t first,
+             std::size_t last, unsigned long seed, Spectra& spectra)
+{
+  std::mt19937_64 engine(seed);
+  std::uniform_real_distribution<double> uniform(0., 1.);
+  auto flat = [&](int n, double* u) {
+    for (int i = 0; i < n; ++i) u[i] = uniform(engine);
+  };
+
+  mirage::DecayKinematics::Sampler sampler;
+  mirage::DecayKinematics::NeutrinoBatch batch;
+  const double planeZ = store.header->zOrigin + options.plane;
+  const double binsPerGeV = options.nofBins / options.maxEnergy;
+
+  for (std::size_t r = first; r < last; ++r) {
+    const mirage::ParentRecord& parent = store.records[r];
+    if (!mirage::DecayKinematics::CanDecay(parent.pdg)) continue;
+
+    const std::size_t n = sampler.Decay(parent.pdg, parent.px, parent.py, parent.pz,
+                                        options.nofDecays, flat, batch);
+    const double weight = parent.weight / options.nofDecays;
+    const double deltaZ = planeZ - parent.z;
+
+    for (std::size_t i = 0; i < n; ++i) {
+      if (batch.pz[i] <= 0.) continue;
+      const double x = parent.x + batch.px[i] / batch.pz[i] * deltaZ - options.centerX;
+      const double y = parent.y + batch.py[i] / batch.pz[i] * deltaZ - options.centerY;
+      if (std::abs(x) >= options.halfWidthX || std::abs(y) >= options.halfWidthY) continue;
+      const int bin = static_cast<int>(batch.E[i] * binsPerGeV);
+      const int flavour = FlavourIndex(batch.pdg[i]);
+      if (bin >= options.nofBins || flavour < 0) continue;
+      spectra[flavour * options.nofBins + bin] += weight;
+    }
+  }
+}
+
+}  // namespace
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+int main(int argc, char** argv)
+{
+  Options options;
+  if (!ParseOptions(argc, argv, options)) return 1;
+
+  auto start = std::chrono::steady_clock::now();
+
+  std::vector<MappedStore> stores;
+  std::uint64_t nofPOT = 0, nofParents = 0;
+  std::size_t nofWithoutMuons = 0;
+  for (const auto& input : options.inputs) {
+    MappedStore store;
+    if (!MapStore(input, store)) return 1;
+    nofPOT += store.header->nofPOT;
+    nofParents += store.header->nofRecords;
+    if (!store.header->HasMuons()) ++nofWithoutMuons;
+    stores.push_back(store);
+  }
+
+  // every store is split over all threads, each with its own random stream
+  const std::size_t nofValues = kNofFlavours * options.nofBins;
+  std::vector<Spectra> spectra(options.nofThreads, Spectra(nofValues, 0.));
+  for (std::size_t s = 0; s < stores.size(); ++s) {
+    const std::size_t nofRecords = stores[s].header->nofRecords;
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < options.nofThreads; ++t) {
+      const std::size_t first = nofRecords * t / options.nofThreads;
+      const std::size_t last = nofRecords * (t + 1) / options.nofThreads;
+      const unsigned long seed = options.seed + 1000003UL * s + t;
+      threads.emplace_back(Redecay, std::cref(options), std::cref(stores[s]),
+                           first, last, seed, std::ref(spectra[t]));
+    }
+    for (auto& thread : threads) thread.join();
+  }
+  for (unsigned t = 1; t < options.nofThreads; ++t) {
+    for (std::size_t k = 0; k < nofValues; ++k) spectra[0][k] += spectra[t][k];
+  }
+
+  for (auto& store : stores) munmap(store.address, store.length);
+
+  const double seconds =
+    std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  FILE* out = stdout;
+  if (!options.output.empty()) {
+    out = std::fopen(options.output.c_str(), "w");
+    if (!out) {
+      std::perror(options.output.c_str());
+      return 1;
+    }
+  }
+
+  // per POT when the stores know it
+  const double norm = nofPOT > 0 ? 1. / nofPOT : 1.;
+  std::fprintf(out, "# parents: %llu  POT: %llu  decays per parent: %d\n",
+               (unsigned long long)nofParents, (unsigned long long)nofPOT, options.nofDecays);
+  std::fprintf(out, "# plane: %g m  window: |x - %g| < %g m, |y - %g| < %g m\n",
+               options.plane, options.centerX, options.halfWidthX,
+               options.centerY, options.halfWidthY);
+  if (nofWithoutMuons > 0) {
+    std::fprintf(out, "# partial: %zu of %zu stores without mu+- decays, nue nuebar numu numubar "
+                      "lack their mu decay part\n", nofWithoutMuons, stores.size());
+  }
+  std::fprintf(out, "# neutrinos in the window per POT per bin\n");
+  std::fprintf(out, "# Emin[GeV] Emax[GeV]");
+  for (int f = 0; f < kNofFlavours; ++f) std::fprintf(out, " %12s", kFlavourNames[f]);
+  std::fprintf(out, "\n");
+  const double binWidth = options.maxEnergy / options.nofBins;
+  for (int bin = 0; bin < options.nofBins; ++bin) {
+    std::fprintf(out, "%10.4g %10.4g", bin * binWidth, (bin + 1) * binWidth);
+    for (int f = 0; f < kNofFlavours; ++f) {
+      std::fprintf(out, " %12.5e", spectra[0][f * options.nofBins + bin] * norm);
+    }
+    std::fprintf(out, "\n");
+  }
+  if (out != stdout) std::fclose(out);
+
+  std::fprintf(stderr, "redecay: %llu parents x %d decays in %.2f s (%u threads)\n",
+               (unsigned long long)nofParents, options.nofDecays, seconds, options.nofThreads);
+  if (nofWithoutMuons > 0) {
+    std::fprintf(stderr, "redecay: warning: %zu store(s) of version 1 have no mu+- decays, the "
+                         "nue, nuebar, numu and numubar spectra are partial\n", nofWithoutMuons);
+  }
+  return 0;
+}